@@ -0,0 +1,252 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * anjuta-directory-cache.c
+ * Copyright (C) Sébastien Granjoux 2009 <seb.sfo@free.fr>
+ * 
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "anjuta-directory-cache.h"
+
+#include "anjuta-debug.h"
+
+#include <string.h>
+
+/**
+ * SECTION:anjuta-directory-cache
+ * @title: Anjuta directory cache
+ * @short_description: Cache of directory contents
+ * @see_also: 
+ * @stability: Unstable
+ * @include: libanjuta/anjuta-directory-cache.h
+ *  
+ * Loading a project checks the existence and the type of a lot of files,
+ * often several names in the same directory. Instead of querying each file,
+ * each directory is enumerated once and all following queries are answered
+ * from memory.
+ *
+ * The cache is shared by all projects and can be used from several threads.
+ * It has to be invalidated when a directory is changed, typically when a
+ * file monitor reports a change or when a file is written. Only the changed
+ * directory should be invalidated, so other projects keep their entries.
+ */ 
+
+/* Types declarations
+ *---------------------------------------------------------------------------*/
+
+/* Directory uri -> hash table of name -> file type */
+static GHashTable *anjuta_directory_cache = NULL;
+
+G_LOCK_DEFINE_STATIC (anjuta_directory_cache);
+
+/* Private functions
+ *---------------------------------------------------------------------------*/
+
+/* Read a directory and return a hash table of all its children. This
+ * function is slow and is called without holding the lock. */
+static GHashTable *
+anjuta_directory_cache_read (GFile *directory)
+{
+	GHashTable *children;
+	GFileEnumerator *enumerator;
+
+	children = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	enumerator = g_file_enumerate_children (directory,
+	                                        G_FILE_ATTRIBUTE_STANDARD_NAME ","
+	                                        G_FILE_ATTRIBUTE_STANDARD_TYPE,
+	                                        G_FILE_QUERY_INFO_NONE,
+	                                        NULL,
+	                                        NULL);
+	if (enumerator != NULL)
+	{
+		GFileInfo *info;
+
+		while ((info = g_file_enumerator_next_file (enumerator, NULL, NULL)) != NULL)
+		{
+			g_hash_table_insert (children,
+			                     g_strdup (g_file_info_get_name (info)),
+			                     GUINT_TO_POINTER (g_file_info_get_file_type (info)));
+			g_object_unref (info);
+		}
+		g_file_enumerator_close (enumerator, NULL, NULL);
+		g_object_unref (enumerator);
+	}
+
+	return children;
+}
+
+/* Public functions
+ *---------------------------------------------------------------------------*/
+
+/**
+ * anjuta_directory_cache_get_file_type:
+ * @directory: a #GFile representing a directory.
+ * @name: a file name in @directory or NULL.
+ *
+ * Get the type of the file @name in @directory, reading the directory only
+ * if it is not already in the cache. If @name is NULL, get the type of
+ * @directory itself.
+ *
+ * Return value: The file type or G_FILE_TYPE_UNKNOWN if the file does not
+ * exist.
+ */
+GFileType
+anjuta_directory_cache_get_file_type (GFile *directory, const gchar *name)
+{
+	GHashTable *children;
+	GFileType type;
+	gchar *uri;
+
+	g_return_val_if_fail (directory != NULL, G_FILE_TYPE_UNKNOWN);
+	
+	if (name == NULL)
+	{
+		GFile *parent = g_file_get_parent (directory);
+		gchar *basename;
+
+		if (parent == NULL)
+		{
+			/* Root directory, not cached */
+			GFileInfo *info;
+			
+			info = g_file_query_info (directory, G_FILE_ATTRIBUTE_STANDARD_TYPE, G_FILE_QUERY_INFO_NONE, NULL, NULL);
+			if (info == NULL) return G_FILE_TYPE_UNKNOWN;
+			type = g_file_info_get_file_type (info);
+			g_object_unref (info);
+
+			return type;
+		}
+		basename = g_file_get_basename (directory);
+		type = anjuta_directory_cache_get_file_type (parent, basename);
+		g_free (basename);
+		g_object_unref (parent);
+
+		return type;
+	}
+	
+	uri = g_file_get_uri (directory);
+	
+	G_LOCK (anjuta_directory_cache);
+	if (anjuta_directory_cache == NULL)
+	{
+		anjuta_directory_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_hash_table_destroy);
+	}
+	children = g_hash_table_lookup (anjuta_directory_cache, uri);
+	if (children == NULL)
+	{
+		GHashTable *read;
+		
+		G_UNLOCK (anjuta_directory_cache);
+		read = anjuta_directory_cache_read (directory);
+		G_LOCK (anjuta_directory_cache);
+
+		/* Another thread could have read the same directory */
+		children = g_hash_table_lookup (anjuta_directory_cache, uri);
+		if (children == NULL)
+		{
+			children = read;
+			g_hash_table_insert (anjuta_directory_cache, uri, children);
+			uri = NULL;
+		}
+		else
+		{
+			g_hash_table_destroy (read);
+		}
+	}
+	type = (GFileType)GPOINTER_TO_UINT (g_hash_table_lookup (children, name));
+	G_UNLOCK (anjuta_directory_cache);
+	g_free (uri);
+
+	return type;
+}
+
+/**
+ * anjuta_directory_cache_query_exists:
+ * @file: a #GFile.
+ *
+ * Check if @file exists using the cache of its parent directory.
+ *
+ * Return value: TRUE if the file exists.
+ */
+gboolean
+anjuta_directory_cache_query_exists (GFile *file)
+{
+	return anjuta_directory_cache_get_file_type (file, NULL) != G_FILE_TYPE_UNKNOWN;
+}
+
+/**
+ * anjuta_directory_cache_invalidate:
+ * @directory: a #GFile representing a directory or NULL.
+ *
+ * Remove @directory from the cache, so it will be read again on the next
+ * query. If @directory is NULL, the whole cache is cleared.
+ */
+void
+anjuta_directory_cache_invalidate (GFile *directory)
+{
+	G_LOCK (anjuta_directory_cache);
+	if (anjuta_directory_cache != NULL)
+	{
+		if (directory == NULL)
+		{
+			g_hash_table_remove_all (anjuta_directory_cache);
+		}
+		else
+		{
+			gchar *uri = g_file_get_uri (directory);
+			
+			g_hash_table_remove (anjuta_directory_cache, uri);
+			g_free (uri);
+		}
+	}
+	G_UNLOCK (anjuta_directory_cache);
+}
+
+/**
+ * anjuta_directory_cache_invalidate_tree:
+ * @directory: a #GFile representing a directory.
+ *
+ * Remove @directory and all its sub directories from the cache, typically
+ * when a whole project is reloaded.
+ */
+void
+anjuta_directory_cache_invalidate_tree (GFile *directory)
+{
+	g_return_if_fail (directory != NULL);
+
+	G_LOCK (anjuta_directory_cache);
+	if (anjuta_directory_cache != NULL)
+	{
+		GHashTableIter iter;
+		gpointer key;
+		gchar *uri;
+		gsize length;
+
+		uri = g_file_get_uri (directory);
+		length = strlen (uri);
+		g_hash_table_iter_init (&iter, anjuta_directory_cache);
+		while (g_hash_table_iter_next (&iter, &key, NULL))
+		{
+			const gchar *child = (const gchar *)key;
+
+			if ((strncmp (child, uri, length) == 0) && ((child[length] == '\0') || (child[length] == '/')))
+			{
+				g_hash_table_iter_remove (&iter);
+			}
+		}
+		g_free (uri);
+	}
+	G_UNLOCK (anjuta_directory_cache);
+}
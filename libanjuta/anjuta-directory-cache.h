@@ -0,0 +1,35 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * anjuta-directory-cache.h
+ * Copyright (C) Sébastien Granjoux 2009 <seb.sfo@free.fr>
+ * 
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _ANJUTA_DIRECTORY_CACHE_H_
+#define _ANJUTA_DIRECTORY_CACHE_H_
+
+#include <glib.h>
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+GFileType anjuta_directory_cache_get_file_type (GFile *directory, const gchar *name);
+gboolean anjuta_directory_cache_query_exists (GFile *file);
+void anjuta_directory_cache_invalidate (GFile *directory);
+void anjuta_directory_cache_invalidate_tree (GFile *directory);
+
+G_END_DECLS
+
+#endif
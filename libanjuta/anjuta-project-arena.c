@@ -0,0 +1,216 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * anjuta-project-arena.c
+ * Copyright (C) Sébastien Granjoux 2009 <seb.sfo@free.fr>
+ * 
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "anjuta-project-arena.h"
+
+#include <string.h>
+
+/**
+ * SECTION:anjuta-project-arena
+ * @title: Anjuta project arena
+ * @short_description: Allocate node data contiguously
+ * @see_also: 
+ * @stability: Unstable
+ * @include: libanjuta/anjuta-project-arena.h
+ *  
+ * A project can allocate the data of its nodes in an arena owned by the
+ * project. The data of each node type are stored in large blocks, one after
+ * the other in loading order, so walking the whole tree reads memory
+ * sequentially instead of jumping between separately allocated records.
+ *
+ * The data of a node can be released alone and its memory is reused by the
+ * next node of the same type. All blocks are freed at once with the arena,
+ * all data have to be released before. An arena cannot be used from
+ * several threads.
+ */ 
+
+/* Types declarations
+ *---------------------------------------------------------------------------*/
+
+#define ANJUTA_PROJECT_ARENA_FIRST_BLOCK	64
+#define ANJUTA_PROJECT_ARENA_MAX_BLOCK		4096
+
+typedef struct _AnjutaProjectArenaPool AnjutaProjectArenaPool;
+
+/* Put before each record to find its pool and keep the data aligned */
+typedef union
+{
+	AnjutaProjectArenaPool *pool;
+	gint64 align_int;
+	gdouble align_double;
+} AnjutaProjectArenaHeader;
+
+struct _AnjutaProjectArenaPool
+{
+	gsize size;					/* Record size including header */
+	GSList *blocks;				/* Allocated memory blocks */
+	guint block_length;			/* Number of records in the next block */
+	gchar *next;				/* Next unused record in the last block */
+	guint remaining;			/* Unused records in the last block */
+	gpointer released;			/* List of released records */
+	guint used;					/* Number of records in use */
+	gsize allocated;			/* Bytes allocated for all blocks */
+};
+
+struct _AnjutaProjectArena
+{
+	AnjutaProjectArenaPool pools[ANJUTA_PROJECT_VARIABLE + 1];
+};
+
+/* Public functions
+ *---------------------------------------------------------------------------*/
+
+/**
+ * anjuta_project_arena_new:
+ *
+ * Create a new empty arena.
+ *
+ * Return value: A new #AnjutaProjectArena, free it with
+ * anjuta_project_arena_free().
+ */
+AnjutaProjectArena *
+anjuta_project_arena_new (void)
+{
+	AnjutaProjectArena *arena;
+	guint i;
+
+	arena = g_slice_new0 (AnjutaProjectArena);
+	for (i = 0; i < G_N_ELEMENTS (arena->pools); i++)
+	{
+		arena->pools[i].block_length = ANJUTA_PROJECT_ARENA_FIRST_BLOCK;
+	}
+
+	return arena;
+}
+
+/**
+ * anjuta_project_arena_free:
+ * @arena: a #AnjutaProjectArena.
+ *
+ * Free the arena and all its memory blocks. The data allocated in the arena
+ * must not be used anymore.
+ */
+void
+anjuta_project_arena_free (AnjutaProjectArena *arena)
+{
+	guint i;
+	
+	if (arena == NULL) return;
+
+	for (i = 0; i < G_N_ELEMENTS (arena->pools); i++)
+	{
+		AnjutaProjectArenaPool *pool = &arena->pools[i];
+
+		if (pool->used != 0) g_warning ("%u nodes are still allocated in project arena", pool->used);
+		g_slist_foreach (pool->blocks, (GFunc)g_free, NULL);
+		g_slist_free (pool->blocks);
+	}
+	g_slice_free (AnjutaProjectArena, arena);
+}
+
+/**
+ * anjuta_project_arena_alloc:
+ * @arena: a #AnjutaProjectArena.
+ * @type: the type of the node.
+ * @size: the size of the node data.
+ *
+ * Allocate zeroed data for a node. All data of the same type must have the
+ * same size.
+ *
+ * Return value: The node data, release it with
+ * anjuta_project_arena_release().
+ */
+gpointer
+anjuta_project_arena_alloc (AnjutaProjectArena *arena, AnjutaProjectNodeType type, gsize size)
+{
+	AnjutaProjectArenaPool *pool;
+	AnjutaProjectArenaHeader *header;
+	gsize record;
+
+	g_return_val_if_fail (type < G_N_ELEMENTS (arena->pools), NULL);
+
+	pool = &arena->pools[type];
+	record = sizeof (AnjutaProjectArenaHeader) + (size + sizeof (AnjutaProjectArenaHeader) - 1) / sizeof (AnjutaProjectArenaHeader) * sizeof (AnjutaProjectArenaHeader);
+	if (pool->size == 0) pool->size = record;
+	g_return_val_if_fail (pool->size == record, NULL);
+
+	if (pool->released != NULL)
+	{
+		/* Reuse a released record */
+		header = (AnjutaProjectArenaHeader *)pool->released - 1;
+		pool->released = *(gpointer *)pool->released;
+	}
+	else
+	{
+		if (pool->remaining == 0)
+		{
+			pool->next = g_malloc (pool->size * pool->block_length);
+			pool->blocks = g_slist_prepend (pool->blocks, pool->next);
+			pool->remaining = pool->block_length;
+			pool->allocated += pool->size * pool->block_length;
+			if (pool->block_length < ANJUTA_PROJECT_ARENA_MAX_BLOCK) pool->block_length *= 2;
+		}
+		header = (AnjutaProjectArenaHeader *)pool->next;
+		pool->next += pool->size;
+		pool->remaining--;
+	}
+	memset (header, 0, pool->size);
+	header->pool = pool;
+	pool->used++;
+	
+	return header + 1;
+}
+
+/**
+ * anjuta_project_arena_release:
+ * @data: node data allocated by anjuta_project_arena_alloc().
+ *
+ * Release the node data, its memory will be used for the next node of the
+ * same type.
+ */
+void
+anjuta_project_arena_release (gpointer data)
+{
+	AnjutaProjectArenaPool *pool;
+
+	if (data == NULL) return;
+
+	pool = ((AnjutaProjectArenaHeader *)data - 1)->pool;
+	*(gpointer *)data = pool->released;
+	pool->released = data;
+	pool->used--;
+}
+
+/**
+ * anjuta_project_arena_get_stats:
+ * @arena: a #AnjutaProjectArena.
+ * @type: a node type.
+ * @used: return location for the number of nodes in use or %NULL.
+ * @allocated: return location for the number of allocated bytes or %NULL.
+ *
+ * Get usage statistics of the arena for one node type.
+ */
+void
+anjuta_project_arena_get_stats (AnjutaProjectArena *arena, AnjutaProjectNodeType type, guint *used, gsize *allocated)
+{
+	g_return_if_fail (type < G_N_ELEMENTS (arena->pools));
+	
+	if (used != NULL) *used = arena->pools[type].used;
+	if (allocated != NULL) *allocated = arena->pools[type].allocated;
+}
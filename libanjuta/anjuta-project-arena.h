@@ -0,0 +1,41 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * anjuta-project-arena.h
+ * Copyright (C) Sébastien Granjoux 2009 <seb.sfo@free.fr>
+ * 
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _ANJUTA_PROJECT_ARENA_H_
+#define _ANJUTA_PROJECT_ARENA_H_
+
+#include <glib.h>
+
+#include "anjuta-project.h"
+
+G_BEGIN_DECLS
+
+typedef struct _AnjutaProjectArena AnjutaProjectArena;
+
+AnjutaProjectArena *anjuta_project_arena_new (void);
+void anjuta_project_arena_free (AnjutaProjectArena *arena);
+
+gpointer anjuta_project_arena_alloc (AnjutaProjectArena *arena, AnjutaProjectNodeType type, gsize size);
+void anjuta_project_arena_release (gpointer data);
+
+void anjuta_project_arena_get_stats (AnjutaProjectArena *arena, AnjutaProjectNodeType type, guint *used, gsize *allocated);
+
+G_END_DECLS
+
+#endif
@@ -242,9 +242,151 @@ anjuta_project_node_prev_sibling (AnjutaProjectNode *node)
 	return g_node_prev_sibling (node);
 }
 
+/* The children of a node are kept in an array, built when needed and
+ * updated by all functions adding or removing a child, so children can be
+ * accessed by position without walking the list */
+
+static GPtrArray *
+anjuta_project_node_get_children (AnjutaProjectNode *node)
+{
+	AnjutaProjectNodeData *data = NODE_DATA (node);
+
+	if (data->children == NULL)
+	{
+		AnjutaProjectNode *child;
+		guint position = 0;
+
+		data->children = g_ptr_array_new ();
+		for (child = g_node_first_child (node); child != NULL; child = g_node_next_sibling (child))
+		{
+			NODE_DATA (child)->position = position++;
+			g_ptr_array_add (data->children, child);
+		}
+	}
+
+	return data->children;
+}
+
+static void
+anjuta_project_node_clear_children (AnjutaProjectNode *node)
+{
+	AnjutaProjectNodeData *data = NODE_DATA (node);
+
+	if ((data != NULL) && (data->children != NULL))
+	{
+		g_ptr_array_free (data->children, TRUE);
+		data->children = NULL;
+	}
+}
+
+/* Renumber the children of the array starting at position */
+static void
+anjuta_project_node_renumber_children (GPtrArray *children, guint position)
+{
+	for (; position < children->len; position++)
+	{
+		NODE_DATA ((AnjutaProjectNode *)g_ptr_array_index (children, position))->position = position;
+	}
+}
+
+/* Add node, just linked in the tree, in the children array of its parent. The
+ * array is discarded if it does not match the siblings of node, it happens
+ * when the data of nodes are exchanged */
+static AnjutaProjectNode *
+anjuta_project_node_insert_child (AnjutaProjectNode *node)
+{
+	AnjutaProjectNodeData *data = NODE_DATA (node->parent);
+	GPtrArray *children;
+	AnjutaProjectNode *prev;
+	AnjutaProjectNode *next;
+	guint position;
+
+	if ((data == NULL) || (data->children == NULL)) return node;
+	children = data->children;
+
+	prev = g_node_prev_sibling (node);
+	next = g_node_next_sibling (node);
+	position = prev != NULL ? NODE_DATA (prev)->position + 1 : 0;
+	if ((position > children->len) ||
+	    ((prev != NULL) && (g_ptr_array_index (children, position - 1) != prev)) ||
+	    ((next == NULL) && (position != children->len)) ||
+	    ((next != NULL) && ((position == children->len) || (g_ptr_array_index (children, position) != next))))
+	{
+		anjuta_project_node_clear_children (node->parent);
+
+		return node;
+	}
+
+	g_ptr_array_add (children, NULL);
+	memmove (&g_ptr_array_index (children, position + 1), &g_ptr_array_index (children, position), (children->len - position - 1) * sizeof (gpointer));
+	g_ptr_array_index (children, position) = node;
+	anjuta_project_node_renumber_children (children, position);
+
+	return node;
+}
+
 AnjutaProjectNode *anjuta_project_node_nth_child (AnjutaProjectNode *node, guint n)
 {
-	return g_node_nth_child (node, n);
+	GPtrArray *children = anjuta_project_node_get_children (node);
+
+	return n < children->len ? (AnjutaProjectNode *)g_ptr_array_index (children, n) : NULL;
+}
+
+/**
+ * anjuta_project_node_get_position:
+ * @node: a #AnjutaProjectNode object.
+ *
+ * Get the position of the node in its parent children list.
+ *
+ * Return value: The position of the node, starting from 0 or -1 if the node
+ * has no parent.
+ */
+gint
+anjuta_project_node_get_position (AnjutaProjectNode *node)
+{
+	GPtrArray *children;
+	guint position;
+
+	if (node->parent == NULL) return -1;
+
+	children = anjuta_project_node_get_children (node->parent);
+	position = NODE_DATA (node)->position;
+	if ((position >= children->len) || (g_ptr_array_index (children, position) != node))
+	{
+		/* The array does not belong to this parent anymore */
+		anjuta_project_node_clear_children (node->parent);
+		anjuta_project_node_get_children (node->parent);
+		position = NODE_DATA (node)->position;
+	}
+
+	return position;
+}
+
+/**
+ * anjuta_project_node_get_path:
+ * @node: a #AnjutaProjectNode object.
+ *
+ * Get the path of the node, the positions of the node and all its parents
+ * separated by colons, starting with 0 for the root node.
+ *
+ * Return value: A newly allocated string.
+ */
+gchar *
+anjuta_project_node_get_path (AnjutaProjectNode *node)
+{
+	GString *path;
+
+	path = g_string_new (NULL);
+	for (; node->parent != NULL; node = node->parent)
+	{
+		gchar *position = g_strdup_printf (":%d", anjuta_project_node_get_position (node));
+
+		g_string_prepend (path, position);
+		g_free (position);
+	}
+	g_string_prepend_c (path, '0');
+
+	return g_string_free (path, FALSE);
 }
 
 typedef struct
@@ -282,25 +424,73 @@ anjuta_project_node_children_foreach (AnjutaProjectNode *node, AnjutaProjectNode
 AnjutaProjectNode *
 anjuta_project_node_append (AnjutaProjectNode *parent, AnjutaProjectNode *node)
 {
-	return g_node_append (parent, node);
+	return anjuta_project_node_insert_child (g_node_append (parent, node));
 }
 
 AnjutaProjectNode *
 anjuta_project_node_insert_before (AnjutaProjectNode *parent, AnjutaProjectNode *sibling, AnjutaProjectNode *node)
 {
-	return g_node_insert_before (parent, sibling, node);
+	return anjuta_project_node_insert_child (g_node_insert_before (parent, sibling, node));
 }
 
 AnjutaProjectNode *
 anjuta_project_node_insert_after (AnjutaProjectNode *parent, AnjutaProjectNode *sibling, AnjutaProjectNode *node)
 {
-	return g_node_insert_after (parent, sibling, node);
+	return anjuta_project_node_insert_child (g_node_insert_after (parent, sibling, node));
 }
 
 AnjutaProjectNode *
 anjuta_project_node_prepend (AnjutaProjectNode *parent, AnjutaProjectNode *node)
 {
-	return g_node_prepend (parent, node);
+	return anjuta_project_node_insert_child (g_node_prepend (parent, node));
+}
+
+/**
+ * anjuta_project_node_remove:
+ * @node: a #AnjutaProjectNode object.
+ *
+ * Remove the node from its parent, the node and its children are not freed.
+ *
+ * Return value: The removed node.
+ */
+AnjutaProjectNode *
+anjuta_project_node_remove (AnjutaProjectNode *node)
+{
+	AnjutaProjectNodeData *data = node->parent != NULL ? NODE_DATA (node->parent) : NULL;
+
+	if ((data != NULL) && (data->children != NULL))
+	{
+		guint position = NODE_DATA (node)->position;
+
+		if ((position < data->children->len) && (g_ptr_array_index (data->children, position) == node))
+		{
+			g_ptr_array_remove_index (data->children, position);
+			anjuta_project_node_renumber_children (data->children, position);
+		}
+		else
+		{
+			anjuta_project_node_clear_children (node->parent);
+		}
+	}
+	g_node_unlink (node);
+
+	return node;
+}
+
+/**
+ * anjuta_project_node_destroy:
+ * @node: a #AnjutaProjectNode object.
+ *
+ * Remove the node from its parent and free it with all its children. The
+ * data of the node has to be still valid, the data of the children are not
+ * freed.
+ */
+void
+anjuta_project_node_destroy (AnjutaProjectNode *node)
+{
+	anjuta_project_node_remove (node);
+	anjuta_project_node_clear_children (node);
+	g_node_destroy (node);
 }
 
 
@@ -320,7 +510,7 @@ anjuta_project_node_get_name (const AnjutaProjectNode *node)
 	case ANJUTA_PROJECT_TARGET:
 		return g_strdup (TARGET_DATA (node)->name);
 	case ANJUTA_PROJECT_SOURCE:
-		return g_file_get_basename (SOURCE_DATA (node)->file);
+		return g_file_get_basename (anjuta_project_source_get_file (node));
 	default:
 		return NULL;
 	}
@@ -345,7 +535,7 @@ anjuta_project_node_get_uri (AnjutaProjectNode *node)
 		g_object_unref (file);
 		break;
 	case ANJUTA_PROJECT_SOURCE:
-		uri = g_file_get_uri (SOURCE_DATA (node)->file);
+		uri = g_file_get_uri (anjuta_project_source_get_file (node));
 		break;
 	default:
 		uri = NULL;
@@ -371,7 +561,7 @@ anjuta_project_node_get_file (AnjutaProjectNode *node)
 		file = g_file_get_child (anjuta_project_group_get_directory (parent), anjuta_project_target_get_name (node));
 		break;
 	case ANJUTA_PROJECT_SOURCE:
-		file = g_object_ref (SOURCE_DATA (node)->file);
+		file = g_object_ref (anjuta_project_source_get_file (node));
 		break;
 	default:
 		file = NULL;
@@ -518,7 +708,7 @@ anjuta_project_source_compare (GNode *node, gpointer data)
 {
 	GFile *file = *(GFile **)data;
 
-	if ((NODE_DATA(node)->type == ANJUTA_PROJECT_SOURCE) && g_file_equal (SOURCE_DATA(node)->file, file))
+	if ((NODE_DATA(node)->type == ANJUTA_PROJECT_SOURCE) && g_file_equal (anjuta_project_source_get_file (node), file))
 	{
 		*(AnjutaProjectNode **)data = node;
 
@@ -571,10 +761,72 @@ anjuta_project_target_get_type (const AnjutaProjectTarget *target)
 /* Source access functions
  *---------------------------------------------------------------------------*/
 
+/**
+ * anjuta_project_source_get_file:
+ * @source: a #AnjutaProjectSource object.
+ *
+ * Get the file of a source. If the source has only a relative path, the file
+ * is created from the directory of its group and kept until the source is
+ * freed or anjuta_project_source_clear_file() is called.
+ *
+ * Return value: The source file owned by the node or %NULL if the source has
+ * no file and is not in a group.
+ */
 GFile*
 anjuta_project_source_get_file (const AnjutaProjectSource *source)
 {
-	return SOURCE_DATA (source)->file;
+	AnjutaProjectSourceData *data = SOURCE_DATA (source);
+	
+	if ((data->file == NULL) && (data->name != NULL))
+	{
+		GNode *group;
+
+		for (group = source->parent; group != NULL; group = group->parent)
+		{
+			if (NODE_DATA (group)->type == ANJUTA_PROJECT_GROUP)
+			{
+				data->file = g_file_resolve_relative_path (GROUP_DATA (group)->directory, data->name);
+				break;
+			}
+		}
+	}
+	
+	return data->file;
+}
+
+/**
+ * anjuta_project_source_get_relative_path:
+ * @source: a #AnjutaProjectSource object.
+ *
+ * Get the path of a source relative to the directory of its group.
+ *
+ * Return value: The relative path or %NULL if the source has been created
+ * with a file only.
+ */
+const gchar *
+anjuta_project_source_get_relative_path (const AnjutaProjectSource *source)
+{
+	return SOURCE_DATA (source)->name;
+}
+
+/**
+ * anjuta_project_source_clear_file:
+ * @source: a #AnjutaProjectSource object.
+ *
+ * Free the file of a source having a relative path. It will be created
+ * again from the group directory when needed, by example after moving the
+ * project.
+ */
+void
+anjuta_project_source_clear_file (AnjutaProjectSource *source)
+{
+	AnjutaProjectSourceData *data = SOURCE_DATA (source);
+
+	if ((data->name != NULL) && (data->file != NULL))
+	{
+		g_object_unref (data->file);
+		data->file = NULL;
+	}
 }
 
 /* Target type functions
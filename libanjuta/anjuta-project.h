@@ -94,6 +94,8 @@ typedef struct
 {
 	AnjutaProjectNodeType type;
 	AnjutaProjectPropertyList *properties;
+	GPtrArray *children;			/* Children array, built when needed */
+	guint position;					/* Position in parent children array */
 } AnjutaProjectNodeData;
 
 typedef struct {
@@ -109,7 +111,8 @@ typedef struct {
 
 typedef struct {
 	AnjutaProjectNodeData node;
-	GFile *file;
+	GFile *file;					/* Created when needed if name is set */
+	const gchar *name;				/* Path relative to the group directory */
 } AnjutaProjectSourceData;
 
 typedef GNode AnjutaProjectNode;
@@ -139,11 +142,15 @@ AnjutaProjectNode *anjuta_project_node_last_child (AnjutaProjectNode *node);
 AnjutaProjectNode *anjuta_project_node_next_sibling (AnjutaProjectNode *node);
 AnjutaProjectNode *anjuta_project_node_prev_sibling (AnjutaProjectNode *node);
 AnjutaProjectNode *anjuta_project_node_nth_child (AnjutaProjectNode *node, guint n);
+gint anjuta_project_node_get_position (AnjutaProjectNode *node);
+gchar *anjuta_project_node_get_path (AnjutaProjectNode *node);
 
 AnjutaProjectNode *anjuta_project_node_append (AnjutaProjectNode *parent, AnjutaProjectNode *node);
 AnjutaProjectNode *anjuta_project_node_prepend (AnjutaProjectNode *parent, AnjutaProjectNode *node);
 AnjutaProjectNode *anjuta_project_node_insert_before (AnjutaProjectNode *parent, AnjutaProjectNode *sibling, AnjutaProjectNode *node);
 AnjutaProjectNode *anjuta_project_node_insert_after (AnjutaProjectNode *parent, AnjutaProjectNode *sibling, AnjutaProjectNode *node);
+AnjutaProjectNode *anjuta_project_node_remove (AnjutaProjectNode *node);
+void anjuta_project_node_destroy (AnjutaProjectNode *node);
 
 void anjuta_project_node_all_foreach (AnjutaProjectNode *node, AnjutaProjectNodeFunc func, gpointer data);
 void anjuta_project_node_children_foreach (AnjutaProjectNode *node, AnjutaProjectNodeFunc func, gpointer data);
@@ -168,6 +175,8 @@ const gchar *anjuta_project_target_get_name (const AnjutaProjectTarget *target);
 AnjutaProjectTargetType anjuta_project_target_get_type (const AnjutaProjectTarget *target);
 
 GFile *anjuta_project_source_get_file (const AnjutaProjectSource *source);
+const gchar *anjuta_project_source_get_relative_path (const AnjutaProjectSource *source);
+void anjuta_project_source_clear_file (AnjutaProjectSource *source);
 
 const gchar *anjuta_project_target_type_name (const AnjutaProjectTargetType type);
 const gchar *anjuta_project_target_type_mime (const AnjutaProjectTargetType type);
@@ -0,0 +1,171 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * anjuta-string-pool.c
+ * Copyright (C) Sébastien Granjoux 2009 <seb.sfo@free.fr>
+ * 
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "anjuta-string-pool.h"
+
+#include <string.h>
+
+/**
+ * SECTION:anjuta-string-pool
+ * @title: Anjuta string pool
+ * @short_description: Store each distinct string once
+ * @see_also: 
+ * @stability: Unstable
+ * @include: libanjuta/anjuta-string-pool.h
+ *  
+ * A project uses the same names many times: directories, targets, variables
+ * or packages. A string pool keeps a single copy of each distinct string,
+ * so interned strings can be used as hash table keys without duplicating
+ * and freeing them and can be compared by pointer.
+ *
+ * All strings are released at once when the pool is freed, the pool cannot
+ * be used from several threads.
+ */ 
+
+/* Types declarations
+ *---------------------------------------------------------------------------*/
+
+struct _AnjutaStringPool
+{
+	GStringChunk *chunk;		/* Memory used by all strings */
+	GHashTable *strings;		/* Interned strings, key and value are equal */
+	gsize saved;				/* Bytes not allocated thanks to the pool */
+};
+
+/* Public functions
+ *---------------------------------------------------------------------------*/
+
+/**
+ * anjuta_string_pool_new:
+ *
+ * Create a new empty string pool.
+ *
+ * Return value: A new #AnjutaStringPool, free it with
+ * anjuta_string_pool_free().
+ */
+AnjutaStringPool *
+anjuta_string_pool_new (void)
+{
+	AnjutaStringPool *pool;
+
+	pool = g_slice_new0 (AnjutaStringPool);
+	pool->chunk = g_string_chunk_new (4096);
+	pool->strings = g_hash_table_new (g_str_hash, g_str_equal);
+
+	return pool;
+}
+
+/**
+ * anjuta_string_pool_free:
+ * @pool: a #AnjutaStringPool.
+ *
+ * Free the pool and all interned strings.
+ */
+void
+anjuta_string_pool_free (AnjutaStringPool *pool)
+{
+	if (pool == NULL) return;
+
+	g_hash_table_destroy (pool->strings);
+	g_string_chunk_free (pool->chunk);
+	g_slice_free (AnjutaStringPool, pool);
+}
+
+/**
+ * anjuta_string_pool_intern:
+ * @pool: a #AnjutaStringPool.
+ * @value: a string or NULL.
+ *
+ * Get the interned copy of a string, adding it to the pool if needed.
+ *
+ * Return value: The interned string, owned by the pool, or NULL if @value
+ * is NULL.
+ */
+const gchar *
+anjuta_string_pool_intern (AnjutaStringPool *pool, const gchar *value)
+{
+	gchar *interned;
+
+	if (value == NULL) return NULL;
+
+	interned = (gchar *)g_hash_table_lookup (pool->strings, value);
+	if (interned == NULL)
+	{
+		interned = g_string_chunk_insert (pool->chunk, value);
+		g_hash_table_insert (pool->strings, interned, interned);
+	}
+	else
+	{
+		pool->saved += strlen (interned) + 1;
+	}
+
+	return interned;
+}
+
+/**
+ * anjuta_string_pool_intern_take:
+ * @pool: a #AnjutaStringPool.
+ * @value: an allocated string or NULL.
+ *
+ * Get the interned copy of a string and free it, useful for strings
+ * returned by functions like anjuta_token_evaluate().
+ *
+ * Return value: The interned string, owned by the pool, or NULL if @value
+ * is NULL.
+ */
+const gchar *
+anjuta_string_pool_intern_take (AnjutaStringPool *pool, gchar *value)
+{
+	const gchar *interned = anjuta_string_pool_intern (pool, value);
+
+	g_free (value);
+
+	return interned;
+}
+
+/**
+ * anjuta_string_pool_lookup:
+ * @pool: a #AnjutaStringPool.
+ * @value: a string.
+ *
+ * Get the interned copy of a string without adding it to the pool.
+ *
+ * Return value: The interned string or NULL if @value is not in the pool.
+ */
+const gchar *
+anjuta_string_pool_lookup (AnjutaStringPool *pool, const gchar *value)
+{
+	return value == NULL ? NULL : (const gchar *)g_hash_table_lookup (pool->strings, value);
+}
+
+/**
+ * anjuta_string_pool_get_stats:
+ * @pool: a #AnjutaStringPool or NULL for an empty pool.
+ * @count: return location for the number of distinct strings or NULL.
+ * @saved: return location for the number of bytes saved or NULL.
+ *
+ * Get the number of strings stored in the pool and the memory saved by
+ * interning strings already in the pool.
+ */
+void
+anjuta_string_pool_get_stats (AnjutaStringPool *pool, guint *count, gsize *saved)
+{
+	if (count != NULL) *count = pool != NULL ? g_hash_table_size (pool->strings) : 0;
+	if (saved != NULL) *saved = pool != NULL ? pool->saved : 0;
+}
@@ -0,0 +1,40 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * anjuta-string-pool.h
+ * Copyright (C) Sébastien Granjoux 2009 <seb.sfo@free.fr>
+ * 
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _ANJUTA_STRING_POOL_H_
+#define _ANJUTA_STRING_POOL_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _AnjutaStringPool AnjutaStringPool;
+
+AnjutaStringPool *anjuta_string_pool_new (void);
+void anjuta_string_pool_free (AnjutaStringPool *pool);
+
+const gchar *anjuta_string_pool_intern (AnjutaStringPool *pool, const gchar *value);
+const gchar *anjuta_string_pool_intern_take (AnjutaStringPool *pool, gchar *value);
+const gchar *anjuta_string_pool_lookup (AnjutaStringPool *pool, const gchar *value);
+
+void anjuta_string_pool_get_stats (AnjutaStringPool *pool, guint *count, gsize *saved);
+
+G_END_DECLS
+
+#endif
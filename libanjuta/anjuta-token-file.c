@@ -20,6 +20,7 @@
 #include "anjuta-token-file.h"
 
 #include "anjuta-debug.h"
+#include "anjuta-directory-cache.h"
 
 #include <glib-object.h>
 
@@ -29,6 +30,17 @@
 /* Types declarations
  *---------------------------------------------------------------------------*/
 
+typedef struct _AnjutaTokenFileFragment AnjutaTokenFileFragment;
+
+struct _AnjutaTokenFileFragment
+{
+	AnjutaToken *token;			/* Content fragment */
+	guint line;					/* Line at the beginning of the fragment */
+	guint column;				/* Column before the first character */
+	guint newline;				/* First new line in newlines array */
+	guint count;				/* Number of new lines in fragment */
+};
+
 struct _AnjutaTokenFile
 {
 	GObject parent;
@@ -38,6 +50,17 @@ struct _AnjutaTokenFile
 	AnjutaToken *content;		/* Current file content */
 
 	AnjutaToken *save;			/* List of memory block used */
+
+	AnjutaTokenPool *pool;		/* Memory used by all tokens of this file */
+
+	GTree *index;				/* Content fragments sorted by address */
+
+	GArray *lines;				/* Line position of content fragments */
+	GArray *newlines;			/* Address of all new line characters */
+	GHashTable *line_map;		/* Content fragment to lines position */
+
+	guint64 hash;				/* Hash of the file content when loaded or saved */
+	gsize length;				/* Length of the file content when loaded or saved */
 };
 
 struct _AnjutaTokenFileClass
@@ -47,19 +70,283 @@ struct _AnjutaTokenFileClass
 
 static GObjectClass *parent_class = NULL;
 
+/* All memory blocks used by loaded files sorted by address, used to find the
+ * file containing a token */
+static GTree *anjuta_token_file_buffers = NULL;
+
 /* Helpers functions
  *---------------------------------------------------------------------------*/
 
+/* 64 bits FNV-1a hash, it can be computed piece by piece while the file
+ * is written */
+#define ANJUTA_TOKEN_FILE_HASH_INIT	G_GUINT64_CONSTANT (14695981039346656037)
+#define ANJUTA_TOKEN_FILE_HASH_PRIME	G_GUINT64_CONSTANT (1099511628211)
+
+static guint64
+anjuta_token_file_hash (guint64 hash, const gchar *data, gsize length)
+{
+	const guchar *ptr = (const guchar *)data;
+	const guchar *end = ptr + length;
+
+	for (; ptr != end; ptr++)
+	{
+		hash ^= *ptr;
+		hash *= ANJUTA_TOKEN_FILE_HASH_PRIME;
+	}
+
+	return hash;
+}
+
+/* Content fragments never overlap, so they can be sorted using the address
+ * of their first character */
+static gint
+anjuta_token_file_compare_fragment (gconstpointer a, gconstpointer b)
+{
+	const gchar *pos_a = anjuta_token_get_string ((AnjutaToken *)a);
+	const gchar *pos_b = anjuta_token_get_string ((AnjutaToken *)b);
+
+	return pos_a < pos_b ? -1 : (pos_a > pos_b ? 1 : 0);
+}
+
+static gint
+anjuta_token_file_search_fragment (gconstpointer key, gconstpointer data)
+{
+	const gchar *pos = (const gchar *)data;
+	const gchar *ptr = anjuta_token_get_string ((AnjutaToken *)key);
+
+	if (pos < ptr) return -1;
+	if (pos >= ptr + anjuta_token_get_length ((AnjutaToken *)key)) return 1;
+
+	return 0;
+}
+
 /* Private functions
  *---------------------------------------------------------------------------*/
 
+static void
+anjuta_token_file_add_buffer (AnjutaTokenFile *file, AnjutaToken *buffer)
+{
+	anjuta_token_prepend_child (file->save, buffer);
+	
+	if (anjuta_token_get_length (buffer) == 0) return;
+	if (anjuta_token_file_buffers == NULL)
+	{
+		anjuta_token_file_buffers = g_tree_new (anjuta_token_file_compare_fragment);
+	}
+	g_tree_insert (anjuta_token_file_buffers, buffer, file);
+}
+
+static void
+anjuta_token_file_remove_buffers (AnjutaTokenFile *file)
+{
+	AnjutaToken *buffer;
+
+	if (anjuta_token_file_buffers == NULL) return;
+	
+	for (buffer = file->save; buffer != NULL; buffer = anjuta_token_next (buffer))
+	{
+		if (anjuta_token_get_length (buffer) != 0)
+		{
+			g_tree_remove (anjuta_token_file_buffers, buffer);
+		}
+	}
+}
+
+/* The index is created when needed, then all functions changing the content
+ * fragments have to keep it up to date */
+
+static void
+anjuta_token_file_index_add (AnjutaTokenFile *file, AnjutaToken *frag)
+{
+	if ((file->index != NULL) && (anjuta_token_get_length (frag) != 0))
+	{
+		g_tree_insert (file->index, frag, frag);
+	}
+}
+
+static void
+anjuta_token_file_index_remove (AnjutaTokenFile *file, AnjutaToken *frag)
+{
+	if ((file->index != NULL) && (anjuta_token_get_length (frag) != 0))
+	{
+		g_tree_remove (file->index, frag);
+	}
+}
+
+static GTree *
+anjuta_token_file_get_index (AnjutaTokenFile *file)
+{
+	if (file->index == NULL)
+	{
+		AnjutaToken *frag;
+		
+		file->index = g_tree_new (anjuta_token_file_compare_fragment);
+		for (frag = file->content; frag != NULL; frag = anjuta_token_next (frag))
+		{
+			anjuta_token_file_index_add (file, frag);
+		}
+	}
+
+	return file->index;
+}
+
+static void
+anjuta_token_file_clear_index (AnjutaTokenFile *file)
+{
+	if (file->index != NULL) g_tree_destroy (file->index);
+	file->index = NULL;
+	if (file->lines != NULL) g_array_free (file->lines, TRUE);
+	file->lines = NULL;
+	if (file->newlines != NULL) g_array_free (file->newlines, TRUE);
+	file->newlines = NULL;
+	if (file->line_map != NULL) g_hash_table_destroy (file->line_map);
+	file->line_map = NULL;
+}
+
+/* The line table is built when needed too. It keeps the line and column at
+ * the beginning of each content fragment and the address of all new line
+ * characters, in file order. Changing a fragment discards the table from
+ * this fragment up to the end of the file. */
+
+static void
+anjuta_token_file_lines_invalidate (AnjutaTokenFile *file, AnjutaToken *frag)
+{
+	gpointer value;
+	guint order;
+	guint i;
+
+	if (file->lines == NULL) return;
+	
+	if (frag == NULL)
+	{
+		/* Discard everything */
+		order = 0;
+	}
+	else if (g_hash_table_lookup_extended (file->line_map, frag, NULL, &value))
+	{
+		order = GPOINTER_TO_UINT (value);
+	}
+	else
+	{
+		/* Fragment not in table */
+		return;
+	}
+
+	for (i = order; i < file->lines->len; i++)
+	{
+		g_hash_table_remove (file->line_map, g_array_index (file->lines, AnjutaTokenFileFragment, i).token);
+	}
+	if (order < file->lines->len)
+	{
+		g_array_set_size (file->newlines, g_array_index (file->lines, AnjutaTokenFileFragment, order).newline);
+		g_array_set_size (file->lines, order);
+	}
+}
+
+static void
+anjuta_token_file_lines_update (AnjutaTokenFile *file)
+{
+	AnjutaTokenFileFragment line = {NULL, 1, 1, 0, 0};
+	AnjutaToken *frag;
+	
+	if (file->lines == NULL)
+	{
+		file->lines = g_array_new (FALSE, FALSE, sizeof (AnjutaTokenFileFragment));
+		file->newlines = g_array_new (FALSE, FALSE, sizeof (const gchar *));
+		file->line_map = g_hash_table_new (g_direct_hash, g_direct_equal);
+	}
+
+	/* Restart after the last valid fragment */
+	if (file->lines->len == 0)
+	{
+		frag = file->content;
+	}
+	else
+	{
+		AnjutaTokenFileFragment *last = &g_array_index (file->lines, AnjutaTokenFileFragment, file->lines->len - 1);
+		const gchar *start = anjuta_token_get_string (last->token);
+		const gchar *end = start + anjuta_token_get_length (last->token);
+		
+		if (last->count == 0)
+		{
+			line.line = last->line;
+			line.column = last->column + (end - start);
+		}
+		else
+		{
+			const gchar *eol = g_array_index (file->newlines, const gchar *, last->newline + last->count - 1);
+			
+			line.line = last->line + last->count;
+			line.column = end - eol;
+		}
+		frag = anjuta_token_next (last->token);
+	}
+	
+	for (; frag != NULL; frag = anjuta_token_next (frag))
+	{
+		if (!(anjuta_token_get_flags (frag) & ANJUTA_TOKEN_REMOVED) && (anjuta_token_get_length (frag)))
+		{
+			const gchar *ptr = anjuta_token_get_string (frag);
+			const gchar *end = ptr + anjuta_token_get_length (frag);
+			const gchar *eol = NULL;
+
+			line.token = frag;
+			line.newline = file->newlines->len;
+			
+			/* memchr is much faster than checking each character */
+			for (; (ptr = memchr (ptr, '\n', end - ptr)) != NULL; ptr++)
+			{
+				g_array_append_val (file->newlines, ptr);
+				eol = ptr;
+			}
+			line.count = file->newlines->len - line.newline;
+			
+			g_hash_table_insert (file->line_map, frag, GUINT_TO_POINTER (file->lines->len));
+			g_array_append_val (file->lines, line);
+
+			/* Compute position at the end of this fragment */
+			if (eol == NULL)
+			{
+				line.column += end - anjuta_token_get_string (frag);
+			}
+			else
+			{
+				line.line += line.count;
+				line.column = end - eol;
+			}
+		}
+	}
+}
+
+static AnjutaToken *
+anjuta_token_file_split_fragment (AnjutaTokenFile *file, AnjutaToken *frag, guint size)
+{
+	AnjutaToken *copy;
+
+	anjuta_token_file_lines_invalidate (file, frag);
+	anjuta_token_file_index_remove (file, frag);
+	copy = anjuta_token_split (frag, size);
+	if (copy != frag) anjuta_token_file_index_add (file, copy);
+	anjuta_token_file_index_add (file, frag);
+
+	return copy;
+}
+
+static AnjutaToken *
+anjuta_token_file_free_fragment (AnjutaTokenFile *file, AnjutaToken *frag)
+{
+	anjuta_token_file_lines_invalidate (file, frag);
+	anjuta_token_file_index_remove (file, frag);
+
+	return anjuta_token_free (frag);
+}
+
 static AnjutaToken*
 anjuta_token_file_find_position (AnjutaTokenFile *file, AnjutaToken *token)
 {
 	AnjutaToken *start;
 	const gchar *pos;
 	const gchar *ptr;
-	const gchar *end;
 	
 	if (token == NULL) return NULL;
 
@@ -76,23 +363,16 @@ anjuta_token_file_find_position (AnjutaTokenFile *file, AnjutaToken *token)
 	}
 
 	pos = anjuta_token_get_string (token);
-	for (start = file->content; start != NULL; start = anjuta_token_next (start))
+	start = (AnjutaToken *)g_tree_search (anjuta_token_file_get_index (file), anjuta_token_file_search_fragment, pos);
+	if (start != NULL)
 	{
-		guint len = anjuta_token_get_length (start);
-			
-		if (len)
+		ptr = anjuta_token_get_string (start);
+		if (ptr != pos)
 		{
-			ptr = anjuta_token_get_string (start);
-			end = ptr + len;
-
-			if ((pos >= ptr) && (pos < end)) break;
+			start = anjuta_token_file_split_fragment (file, start, pos - ptr);
+			start = anjuta_token_next (start);
 		}
 	}
-	if ((start != NULL) && (ptr != pos))
-	{
-		start = anjuta_token_split (start, pos - ptr);
-		start = anjuta_token_next (start);
-	}
 
 	return start;
 }
@@ -106,34 +386,141 @@ anjuta_token_file_load (AnjutaTokenFile *file, GError **error)
 	gchar *content;
 	gsize length;
 
+	if (!g_file_load_contents (file->file, NULL, &content, &length, NULL, error))
+	{
+		content = NULL;
+		length = 0;
+	}
+	else if (length > G_MAXUINT32)
+	{
+		/* Token length is stored on 32 bits */
+		g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "File is too big");
+		g_free (content);
+		content = NULL;
+		length = 0;
+	}
+
+	return anjuta_token_file_load_data (file, content, length);
+}
+
+/**
+ * anjuta_token_file_load_data:
+ * @file: a #AnjutaTokenFile derived class object.
+ * @content: file content or NULL, as returned by g_file_load_contents().
+ * @length: length of @content.
+ * 
+ * Load the file using already read data, the file object takes the
+ * ownership of @content. It allows to read the file in another thread.
+ * 
+ * Return value: The file content token.
+ */
+AnjutaToken*
+anjuta_token_file_load_data (AnjutaTokenFile *file, gchar *content, gsize length)
+{
+	g_return_val_if_fail ((content == NULL) || (length <= G_MAXUINT32), NULL);
+
 	anjuta_token_file_unload (file);
+
+	file->hash = anjuta_token_file_hash (ANJUTA_TOKEN_FILE_HASH_INIT, content, content != NULL ? length : 0);
+	file->length = content != NULL ? length : 0;
+
+	file->pool = anjuta_token_pool_new ();
+	anjuta_token_pool_push (file->pool);
 	
 	file->save = anjuta_token_new_static (ANJUTA_TOKEN_FILE,  NULL);
 	file->content = anjuta_token_new_static (ANJUTA_TOKEN_FILE,  NULL);
 	
-	if (g_file_load_contents (file->file, NULL, &content, &length, NULL, error))
+	if (content != NULL)
 	{
 		AnjutaToken *token;
+
+		/* Add two null characters, needed by the lexer to scan the
+		 * content in place */
+		content = g_realloc (content, length + 2);
+		content[length] = '\0';
+		content[length + 1] = '\0';
 			
 		token =	anjuta_token_new_with_string (ANJUTA_TOKEN_FILE, content, length);
-		anjuta_token_prepend_child (file->save, token);
+		anjuta_token_file_add_buffer (file, token);
 		
-		token =	anjuta_token_new_static (ANJUTA_TOKEN_FILE, content);
+		token =	anjuta_token_new_fragment (ANJUTA_TOKEN_FILE | ANJUTA_TOKEN_PADDED, content, length);
 		anjuta_token_prepend_child (file->content, token);
 	}
+	anjuta_token_pool_pop ();
 	
 	return file->content;
 }
 
+/**
+ * anjuta_token_file_replace_data:
+ * @file: a #AnjutaTokenFile derived class object.
+ * @content: new file content, as returned by g_file_load_contents().
+ * @length: length of @content.
+ * 
+ * Replace the file content keeping all tokens allocated for this file. The
+ * file object takes the ownership of @content. It works only if the file
+ * content has not been modified, the caller has to move the tokens pointing
+ * in the old content into the new one.
+ * 
+ * Return value: The content fragment, pointing to the new content or NULL
+ * if the content cannot be replaced. In this case, @content is not used.
+ */
+AnjutaToken*
+anjuta_token_file_replace_data (AnjutaTokenFile *file, gchar *content, gsize length)
+{
+	AnjutaToken *frag;
+	AnjutaToken *buffer;
+
+	if ((file->content == NULL) || (file->save == NULL) || (content == NULL) || (length > G_MAXUINT32)) return NULL;
+
+	/* Only a single unmodified fragment can be replaced */
+	frag = anjuta_token_next (file->content);
+	buffer = anjuta_token_next (file->save);
+	if ((frag == NULL) || (anjuta_token_next (frag) != NULL)) return NULL;
+	if ((buffer == NULL) || (anjuta_token_next (buffer) != NULL)) return NULL;
+	if (!(anjuta_token_get_flags (frag) & ANJUTA_TOKEN_PADDED)) return NULL;
+
+	anjuta_token_file_clear_index (file);
+	anjuta_token_file_remove_buffers (file);
+	anjuta_token_free (buffer);
+	anjuta_token_free (frag);
+
+	file->hash = anjuta_token_file_hash (ANJUTA_TOKEN_FILE_HASH_INIT, content, length);
+	file->length = length;
+	
+	content = g_realloc (content, length + 2);
+	content[length] = '\0';
+	content[length + 1] = '\0';
+
+	anjuta_token_pool_push (file->pool);
+	buffer = anjuta_token_new_with_string (ANJUTA_TOKEN_FILE, content, length);
+	anjuta_token_file_add_buffer (file, buffer);
+	frag = anjuta_token_new_fragment (ANJUTA_TOKEN_FILE | ANJUTA_TOKEN_PADDED, content, length);
+	anjuta_token_prepend_child (file->content, frag);
+	anjuta_token_pool_pop ();
+
+	return frag;
+}
+
 gboolean
 anjuta_token_file_unload (AnjutaTokenFile *file)
 {
+	anjuta_token_file_clear_index (file);
+	
 	if (file->content != NULL) anjuta_token_free (file->content);
 	file->content = NULL;
 	
-	if (file->save != NULL) anjuta_token_free (file->save);
+	if (file->save != NULL)
+	{
+		anjuta_token_file_remove_buffers (file);
+		anjuta_token_free (file->save);
+	}
 	file->save = NULL;
 
+	/* Release all tokens allocated while parsing this file */
+	anjuta_token_pool_free (file->pool);
+	file->pool = NULL;
+
 	return TRUE;
 }
 
@@ -144,6 +531,8 @@ anjuta_token_file_save (AnjutaTokenFile *file, GError **error)
 	gboolean ok = TRUE;
 	GError *err = NULL;
 	AnjutaToken *token;
+	guint64 hash = ANJUTA_TOKEN_FILE_HASH_INIT;
+	gsize length = 0;
 	
 	stream = g_file_replace (file->file, NULL, FALSE, G_FILE_CREATE_NONE, NULL, &err);
 	if (stream == NULL)
@@ -152,9 +541,26 @@ anjuta_token_file_save (AnjutaTokenFile *file, GError **error)
 		{
 			/* Perhaps parent directory is missing, try to create it */
 			GFile *parent = g_file_get_parent (file->file);
+			GFile *existing;
+
+			/* Find the nearest existing ancestor, getting the new
+			 * directories */
+			for (existing = g_object_ref (parent); (existing != NULL) && !g_file_query_exists (existing, NULL);)
+			{
+				GFile *up = g_file_get_parent (existing);
+
+				g_object_unref (existing);
+				existing = up;
+			}
 			
 			if (g_file_make_directory_with_parents (parent, NULL, NULL))
 			{
+				/* Several directories can be created below it */
+				if (existing != NULL)
+				{
+					anjuta_directory_cache_invalidate_tree (existing);
+					g_object_unref (existing);
+				}
 				g_object_unref (parent);
 				g_clear_error (&err);
 				stream = g_file_replace (file->file, NULL, FALSE, G_FILE_CREATE_NONE, NULL, error);
@@ -162,6 +568,7 @@ anjuta_token_file_save (AnjutaTokenFile *file, GError **error)
 			}
 			else
 			{
+				if (existing != NULL) g_object_unref (existing);
 				g_object_unref (parent);
 				g_propagate_error (error, err);
 
@@ -184,11 +591,31 @@ anjuta_token_file_save (AnjutaTokenFile *file, GError **error)
 				ok = FALSE;
 				break;
 			}
+			hash = anjuta_token_file_hash (hash, anjuta_token_get_string (token), anjuta_token_get_length (token));
+			length += anjuta_token_get_length (token);
 		}
 	}
 		
 	ok = ok && g_output_stream_close (G_OUTPUT_STREAM (stream), NULL, NULL);
 	g_object_unref (stream);
+
+	if (ok)
+	{
+		/* The tokens match the new file content */
+		file->hash = hash;
+		file->length = length;
+	}
+
+	/* The file could be new */
+	{
+		GFile *parent = g_file_get_parent (file->file);
+
+		if (parent != NULL)
+		{
+			anjuta_directory_cache_invalidate (parent);
+			g_object_unref (parent);
+		}
+	}
 	
 	return ok;
 }
@@ -269,10 +696,10 @@ anjuta_token_file_update (AnjutaTokenFile *file, AnjutaToken *token)
 					guint flen = anjuta_token_get_length (pos);
 					if (len < flen)
 					{
-						pos = anjuta_token_split (pos, len);
+						pos = anjuta_token_file_split_fragment (file, pos, len);
 						flen = len;
 					}
-					pos = anjuta_token_free (pos);
+					pos = anjuta_token_file_free_fragment (file, pos);
 					len -= flen;
 				}
 				next = anjuta_token_free (next);
@@ -294,25 +721,27 @@ anjuta_token_file_update (AnjutaTokenFile *file, AnjutaToken *token)
 		AnjutaToken *start = NULL;
 		
 		value = g_new (gchar, added);
-		anjuta_token_prepend_child (file->save, anjuta_token_new_with_string (ANJUTA_TOKEN_NAME, value, added));
+		anjuta_token_file_add_buffer (file, anjuta_token_new_with_string (ANJUTA_TOKEN_NAME, value, added));
 		
 		/* Find token position */
 		if (prev != NULL)
 		{
 			start = anjuta_token_file_find_position (file, prev);
-			if (start != NULL) start = anjuta_token_split (start, anjuta_token_get_length (prev));
+			if (start != NULL) start = anjuta_token_file_split_fragment (file, start, anjuta_token_get_length (prev));
 		}
 
 		/* Insert token */
 		add = anjuta_token_new_fragment (ANJUTA_TOKEN_NAME, value, added);
 		if (start == NULL)
 		{
+			anjuta_token_file_lines_invalidate (file, NULL);
 			anjuta_token_prepend_child (file->content, add);
 		}
 		else
 		{
 			anjuta_token_insert_after (start, add);
 		}
+		anjuta_token_file_index_add (file, add);
 
 		for (next = token; (next != NULL) && (next != last); next = anjuta_token_next (next))
 		{
@@ -343,49 +772,58 @@ anjuta_token_file_update (AnjutaTokenFile *file, AnjutaToken *token)
 gboolean
 anjuta_token_file_get_token_location (AnjutaTokenFile *file, AnjutaTokenFileLocation *location, AnjutaToken *token)
 {
-	AnjutaTokenFileLocation loc = {NULL, 1, 1};
-	AnjutaToken *pos;
+	AnjutaToken *frag;
+	AnjutaTokenFileFragment *line;
 	const gchar *target = anjuta_token_get_string (token);
+	gpointer value;
+	guint first;
+	guint last;
 	
-	for (pos = file->content; pos != NULL; pos = anjuta_token_next (pos))
+	if (target == NULL) return FALSE;
+
+	/* Find content fragment */
+	frag = (AnjutaToken *)g_tree_search (anjuta_token_file_get_index (file), anjuta_token_file_search_fragment, target);
+	if (frag == NULL) return FALSE;
+	if ((file->line_map == NULL) || !g_hash_table_lookup_extended (file->line_map, frag, NULL, &value))
 	{
-		if (!(anjuta_token_get_flags (pos) & ANJUTA_TOKEN_REMOVED) && (anjuta_token_get_length (pos)))
-		{
-			const gchar *ptr;
-			const gchar *end;
+		anjuta_token_file_lines_update (file);
+		if (!g_hash_table_lookup_extended (file->line_map, frag, NULL, &value)) return FALSE;
+	}
+	line = &g_array_index (file->lines, AnjutaTokenFileFragment, GPOINTER_TO_UINT (value));
 
-			ptr = anjuta_token_get_string (pos);
-			end = ptr + anjuta_token_get_length (pos);
-			
-			for (; ptr != end; ptr++)
-			{
-				if (*ptr == '\n')
-				{
-					/* New line */
-					loc.line++;
-					loc.column = 1;
-				}
-				else
-				{
-					loc.column++;
-				}
-					
-				if (ptr == target)
-				{
-					if (location != NULL)
-					{
-						location->filename = file->file == NULL ? NULL : g_file_get_parse_name (file->file);
-						location->line = loc.line;
-						location->column = loc.column;
-					}
+	/* Binary search of the number of new lines before or at target */
+	first = line->newline;
+	last = line->newline + line->count;
+	while (first < last)
+	{
+		guint middle = (first + last) / 2;
 
-					return TRUE;
-				}
-			}
+		if (g_array_index (file->newlines, const gchar *, middle) <= target)
+		{
+			first = middle + 1;
+		}
+		else
+		{
+			last = middle;
+		}
+	}
+
+	if (location != NULL)
+	{
+		location->filename = file->file == NULL ? NULL : g_file_get_parse_name (file->file);
+		if (first == line->newline)
+		{
+			location->line = line->line;
+			location->column = line->column + (target - anjuta_token_get_string (frag)) + 1;
+		}
+		else
+		{
+			location->line = line->line + (first - line->newline);
+			location->column = target - g_array_index (file->newlines, const gchar *, first - 1) + 1;
 		}
 	}
 
-	return FALSE;
+	return TRUE;
 }
 
 GFile*
@@ -394,6 +832,63 @@ anjuta_token_file_get_file (AnjutaTokenFile *file)
 	return file->file;
 }
 
+/**
+ * anjuta_token_file_get_pool:
+ * @file: a #AnjutaTokenFile derived class object.
+ * 
+ * Get the pool used to allocate the tokens of this file. It is created when
+ * the file is loaded and released with all its tokens when the file is
+ * unloaded. Make it active with anjuta_token_pool_push() while parsing the
+ * file.
+ * 
+ * Return value: The token pool or NULL if the file is not loaded.
+ */
+AnjutaTokenPool*
+anjuta_token_file_get_pool (AnjutaTokenFile *file)
+{
+	return file->pool;
+}
+
+/**
+ * anjuta_token_file_lookup:
+ * @token: a #AnjutaToken object.
+ * 
+ * Find the loaded file containing the characters of @token. The search
+ * uses the address of the characters, so it takes O(log n) time where n is
+ * the number of loaded files.
+ * 
+ * Return value: The #AnjutaTokenFile containing the token or NULL.
+ */
+AnjutaTokenFile*
+anjuta_token_file_lookup (AnjutaToken *token)
+{
+	const gchar *pos = anjuta_token_get_string (token);
+	
+	if ((pos == NULL) || (anjuta_token_file_buffers == NULL)) return NULL;
+
+	return (AnjutaTokenFile *)g_tree_search (anjuta_token_file_buffers, anjuta_token_file_search_fragment, pos);
+}
+
+/**
+ * anjuta_token_file_is_same_content:
+ * @file: a #AnjutaTokenFile derived class object.
+ * @content: new file content.
+ * @length: length of @content.
+ * 
+ * Compare @content with the file content when it has been loaded or saved
+ * for the last time, using its length and a hash. It allows to keep the
+ * tokens when a file is rewritten with the same content.
+ * 
+ * Return value: TRUE if the content has not changed.
+ */
+gboolean
+anjuta_token_file_is_same_content (AnjutaTokenFile *file, const gchar *content, gsize length)
+{
+	if ((file->content == NULL) || (length != file->length)) return FALSE;
+
+	return anjuta_token_file_hash (ANJUTA_TOKEN_FILE_HASH_INIT, content, length) == file->hash;
+}
+
 AnjutaToken*
 anjuta_token_file_get_content (AnjutaTokenFile *file)
 {
@@ -435,6 +930,13 @@ anjuta_token_file_instance_init (AnjutaTokenFile *file)
 	file->file = NULL;
 	file->content = NULL;
 	file->save = NULL;
+	file->pool = NULL;
+	file->index = NULL;
+	file->lines = NULL;
+	file->newlines = NULL;
+	file->line_map = NULL;
+	file->hash = 0;
+	file->length = 0;
 }
 
 /* class_init intialize the class itself not the instance */
@@ -50,6 +50,8 @@ AnjutaTokenFile *anjuta_token_file_new (GFile *file);
 void anjuta_token_file_free (AnjutaTokenFile *file);
 
 AnjutaToken* anjuta_token_file_load (AnjutaTokenFile *file, GError **error);
+AnjutaToken* anjuta_token_file_load_data (AnjutaTokenFile *file, gchar *content, gsize length);
+AnjutaToken* anjuta_token_file_replace_data (AnjutaTokenFile *file, gchar *content, gsize length);
 gboolean anjuta_token_file_unload (AnjutaTokenFile *file);
 gboolean anjuta_token_file_save (AnjutaTokenFile *file, GError **error);
 void anjuta_token_file_move (AnjutaTokenFile *file, GFile *new_file);
@@ -59,6 +61,9 @@ gboolean anjuta_token_file_update (AnjutaTokenFile *file, AnjutaToken *token);
 gboolean anjuta_token_file_get_token_location (AnjutaTokenFile *file, AnjutaTokenFileLocation *location, AnjutaToken *token);
 GFile *anjuta_token_file_get_file (AnjutaTokenFile *file);
 AnjutaToken *anjuta_token_file_get_content (AnjutaTokenFile *file);
+AnjutaTokenPool *anjuta_token_file_get_pool (AnjutaTokenFile *file);
+AnjutaTokenFile *anjuta_token_file_lookup (AnjutaToken *token);
+gboolean anjuta_token_file_is_same_content (AnjutaTokenFile *file, const gchar *content, gsize length);
 
 
 G_END_DECLS
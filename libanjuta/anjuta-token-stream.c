@@ -73,6 +73,11 @@ struct _AnjutaTokenStream
 	
     /* Output stream */
     AnjutaToken *root;
+
+	/* Input stream in one memory block, scanned in place */
+	gchar *buffer;
+	gsize length;
+	const gchar *cursor;
 	
 	/* Parent stream */
     AnjutaTokenStream *parent;    
@@ -81,6 +86,32 @@ struct _AnjutaTokenStream
 /* Helpers functions
  *---------------------------------------------------------------------------*/
 
+/* Create a token with part of the characters of an input token. Like
+ * anjuta_token_cut but without copying the token when the characters are
+ * static */
+static AnjutaToken *
+anjuta_token_stream_cut (AnjutaToken *token, gint type, gsize pos, gsize length)
+{
+	AnjutaToken *copy;
+	gsize toklen = anjuta_token_get_length (token);
+	
+	if (!(anjuta_token_get_flags (token) & ANJUTA_TOKEN_STATIC))
+	{
+		copy = anjuta_token_cut (token, pos, length);
+		anjuta_token_set_type (copy, type);
+
+		return copy;
+	}
+	
+	if (pos >= toklen)
+	{
+		return anjuta_token_new_fragment (type | (anjuta_token_get_flags (token) & ~ANJUTA_TOKEN_PADDED), NULL, 0);
+	}
+	if ((pos + length) > toklen) length = toklen - pos;
+
+	return anjuta_token_new_fragment (type | (anjuta_token_get_flags (token) & ~ANJUTA_TOKEN_PADDED), anjuta_token_get_string (token) + pos, length);
+}
+
 /* Private functions
  *---------------------------------------------------------------------------*/
 
@@ -115,17 +146,26 @@ anjuta_token_stream_append_token (AnjutaTokenStream *stream, AnjutaToken *token)
 AnjutaToken* 
 anjuta_token_stream_tokenize (AnjutaTokenStream *stream, gint type, gsize length)
 {
-    AnjutaToken *frag;
+    AnjutaToken *frag = NULL;
     AnjutaToken *end;
 
-    frag = anjuta_token_new_fragment (type, NULL, 0);
+	if (stream->buffer != NULL)
+	{
+		/* Lexer reads directly the input buffer */
+		frag = anjuta_token_new_fragment (type, stream->cursor, length);
+		stream->cursor += length;
+		anjuta_token_stream_append_token (stream, frag);
+
+		return frag;
+	}
 
+    /* The group token is allocated only when needed, the tokens are
+     * often allocated in a pool where freeing them does nothing */
     for (end = stream->start; end != NULL;)
     {
         if (anjuta_token_get_type (end) < ANJUTA_TOKEN_PARSED)
         {
             gint toklen = anjuta_token_get_length (end);
-            AnjutaToken *copy = anjuta_token_cut (end, stream->begin, length);
     
             if (toklen >= (length + stream->begin))
             {
@@ -133,14 +173,13 @@ anjuta_token_stream_tokenize (AnjutaTokenStream *stream, gint type, gsize length
                 if (end == stream->start)
                 {
                     /* Get whole token */
-                    anjuta_token_free (frag);
-                    anjuta_token_set_type (copy, type);
-                    frag = copy;
+                    frag = anjuta_token_stream_cut (end, type, stream->begin, length);
                 }
                 else
                 {
                     /* Get several token */
-                    anjuta_token_append_child (frag, copy);
+                    if (frag == NULL) frag = anjuta_token_new_fragment (type, NULL, 0);
+                    anjuta_token_append_child (frag, anjuta_token_stream_cut (end, anjuta_token_get_type (end), stream->begin, length));
                 }
 
                 if (toklen == (length + stream->begin))
@@ -157,8 +196,9 @@ anjuta_token_stream_tokenize (AnjutaTokenStream *stream, gint type, gsize length
             }
             else
             {
-                anjuta_token_append_child (frag, copy);
-                length -= toklen;
+                if (frag == NULL) frag = anjuta_token_new_fragment (type, NULL, 0);
+                anjuta_token_append_child (frag, anjuta_token_stream_cut (end, anjuta_token_get_type (end), stream->begin, length));
+                length -= toklen - stream->begin;
                 end = anjuta_token_next (end);
                 stream->begin = 0;
             }
@@ -169,6 +209,7 @@ anjuta_token_stream_tokenize (AnjutaTokenStream *stream, gint type, gsize length
             stream->begin = 0;
         }
     }
+    if (frag == NULL) frag = anjuta_token_new_fragment (type, NULL, 0);
     
     anjuta_token_stream_append_token (stream, frag);
 
@@ -242,6 +283,28 @@ anjuta_token_stream_read (AnjutaTokenStream *stream, gchar *buffer, gsize max_si
     return result;
 }
 
+/**
+ * anjuta_token_stream_get_buffer:
+ * @stream: a #AnjutaTokenStream object.
+ * @length: a place to put the buffer length.
+ *
+ * Return the input stream characters if they are all in one memory block
+ * followed by two null characters. The lexer can then scan this buffer in
+ * place instead of calling anjuta_token_stream_read(). The buffer is
+ * modified temporarily during the scan.
+ *
+ * Return value: The input buffer or NULL if it is not available.
+ */
+gchar *
+anjuta_token_stream_get_buffer (AnjutaTokenStream *stream, gsize *length)
+{
+	g_return_val_if_fail (stream != NULL, NULL);
+
+	if (length != NULL) *length = stream->length;
+	
+	return stream->buffer;
+}
+
 /**
  * anjuta_token_stream_get_root:
  * @stream: a #AnjutaTokenStream object.
@@ -291,6 +354,20 @@ anjuta_token_stream_push (AnjutaTokenStream *parent, AnjutaToken *token)
     if (child->last == token) child->last = NULL;
 
 	child->root = anjuta_token_new_static (ANJUTA_TOKEN_FILE, NULL);
+
+	/* Check if the input is a single padded memory block */
+	child->buffer = NULL;
+	child->length = 0;
+	child->cursor = NULL;
+	if ((child->next != NULL) && (child->next == child->last)
+	    && (anjuta_token_get_flags (child->next) & ANJUTA_TOKEN_PADDED)
+	    && (anjuta_token_get_type (child->next) < ANJUTA_TOKEN_PARSED)
+	    && (anjuta_token_get_length (child->next) != 0))
+	{
+		child->buffer = (gchar *)anjuta_token_get_string (child->next);
+		child->length = anjuta_token_get_length (child->next);
+		child->cursor = child->buffer;
+	}
 	
 	return child;
 }
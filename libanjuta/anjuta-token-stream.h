@@ -32,6 +32,7 @@ AnjutaTokenStream *anjuta_token_stream_push (AnjutaTokenStream *stream, AnjutaTo
 AnjutaTokenStream *anjuta_token_stream_pop (AnjutaTokenStream *stream);
 
 AnjutaToken* anjuta_token_stream_get_root (AnjutaTokenStream *stream);
+gchar *anjuta_token_stream_get_buffer (AnjutaTokenStream *stream, gsize *length);
 
 AnjutaToken* anjuta_token_stream_tokenize (AnjutaTokenStream *stream, gint type, gsize length);
 gint anjuta_token_stream_read (AnjutaTokenStream *stream, gchar *buffer, gsize max_size);
@@ -64,20 +64,43 @@
  * end in another included file. The grouping can be nested too. Typically
  * we can have a group representing a command, a sub group representing the 
  * arguments and then one sub group for each argument.
+ *
+ * Tokens are small and created by millions when loading a big project, so
+ * they can be allocated from a #AnjutaTokenPool instead of one by one. A pool
+ * is made active with anjuta_token_pool_push(), all tokens created afterward
+ * are bump-allocated in large chunks of this pool until it is removed with
+ * anjuta_token_pool_pop(). Such tokens are marked with the
+ * ANJUTA_TOKEN_POOLED flag, freeing them puts them in a free list of their
+ * pool, reused for the next tokens, the memory is released all at once by
+ * anjuta_token_pool_free(). Tokens owning their string are never allocated
+ * in a pool. A scanner creating temporary tokens can push its own short
+ * lived pool, so they do not stay in the pool of the file. Pools are not
+ * locked, they have to be used only in the thread creating them and a pooled
+ * token must not be freed after its pool.
+ *
+ * The ANJUTA_TOKEN_PADDED flag marks a token whose characters are followed by
+ * two null characters, so a lexer can scan them in place. It is not kept
+ * when the token is copied or its string is changed.
+ *
+ * A whole token tree can be saved with anjuta_token_save_tree() and recreated
+ * with anjuta_token_load_tree(), without parsing the file again.
  */ 
 
 
 typedef struct _AnjutaTokenData AnjutaTokenData;
 
+/* The token type uses the lower bits of flags, see ANJUTA_TOKEN_TYPE and
+ * ANJUTA_TOKEN_FLAGS. Keeping both with a 32 bits length reduces the size of
+ * a token from 80 to 64 bytes on 64 bits architecture. */
 struct _AnjutaTokenData
 {
-	AnjutaTokenData *data;
-	AnjutaTokenType type;	
 	gint flags;
+	guint32 length;
 	gchar *pos;
-	gsize length;
 };
 
+#define ANJUTA_TOKEN_DATA_TYPE(token)	((token)->data.flags & ANJUTA_TOKEN_TYPE)
+
 struct _AnjutaToken
 {
 	AnjutaToken	*next;
@@ -89,9 +112,146 @@ struct _AnjutaToken
 	AnjutaTokenData data;
 };
 
+/* Number of tokens allocated at once in a pool */
+#define ANJUTA_TOKEN_POOL_CHUNK		1024
+
+struct _AnjutaTokenPool
+{
+	GSList *chunks;			/* List of allocated memory blocks */
+	AnjutaToken *next;		/* Next free token in current block */
+	AnjutaToken *end;		/* End of current block */
+	AnjutaToken *released;	/* Freed tokens, linked by their next field */
+	guint count;			/* Number of used tokens */
+	GThread *thread;		/* Thread creating the pool */
+};
+
+typedef struct _AnjutaTokenPoolChunk AnjutaTokenPoolChunk;
+
+struct _AnjutaTokenPoolChunk
+{
+	AnjutaToken *first;
+	AnjutaTokenPool *pool;
+};
+
+/* Stack of active pools, the first one is used for new tokens */
+static GSList *anjuta_token_pool_stack = NULL;
+
+/* Memory blocks of all pools sorted by address, to find the pool of a freed
+ * token. Blocks are usually allocated at increasing addresses so a new one is
+ * appended. Else inserting it moves at most all entries, the cost of
+ * 16 bytes per existing block is shared by the ANJUTA_TOKEN_POOL_CHUNK tokens
+ * of the new block, so it stays below the size of a token up to 4096 blocks,
+ * 4 millions tokens. */
+static GArray *anjuta_token_pool_chunks = NULL;
+
 /* Helpers functions
  *---------------------------------------------------------------------------*/
 
+/* Return the position of the last memory block starting at or before
+ * token or -1 if there is none */
+static gint
+anjuta_token_pool_find_chunk (AnjutaToken *token)
+{
+	gint low = 0;
+	gint high;
+
+	if (anjuta_token_pool_chunks == NULL) return -1;
+
+	high = (gint)anjuta_token_pool_chunks->len - 1;
+	while (low <= high)
+	{
+		gint mid = (low + high) / 2;
+
+		if (g_array_index (anjuta_token_pool_chunks, AnjutaTokenPoolChunk, mid).first <= token)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid - 1;
+		}
+	}
+
+	return high;
+}
+
+/* Return the pool owning a pooled token */
+static AnjutaTokenPool *
+anjuta_token_pool_lookup (AnjutaToken *token)
+{
+	AnjutaTokenPoolChunk *chunk;
+	gint pos;
+
+	pos = anjuta_token_pool_find_chunk (token);
+	if (pos < 0) return NULL;
+
+	chunk = &g_array_index (anjuta_token_pool_chunks, AnjutaTokenPoolChunk, pos);
+
+	return token < chunk->first + ANJUTA_TOKEN_POOL_CHUNK ? chunk->pool : NULL;
+}
+
+/* Allocate a new token in the given pool */
+static AnjutaToken *
+anjuta_token_pool_alloc (AnjutaTokenPool *pool)
+{
+	AnjutaToken *token;
+
+	g_assert (pool->thread == g_thread_self ());
+
+	if (pool->released != NULL)
+	{
+		/* Reuse a freed token */
+		token = pool->released;
+		pool->released = token->next;
+	}
+	else
+	{
+		if (pool->next == pool->end)
+		{
+			AnjutaTokenPoolChunk chunk;
+
+			pool->next = g_new (AnjutaToken, ANJUTA_TOKEN_POOL_CHUNK);
+			pool->end = pool->next + ANJUTA_TOKEN_POOL_CHUNK;
+			pool->chunks = g_slist_prepend (pool->chunks, pool->next);
+
+			chunk.first = pool->next;
+			chunk.pool = pool;
+			if (anjuta_token_pool_chunks == NULL) anjuta_token_pool_chunks = g_array_new (FALSE, FALSE, sizeof (AnjutaTokenPoolChunk));
+			if ((anjuta_token_pool_chunks->len == 0) ||
+				(g_array_index (anjuta_token_pool_chunks, AnjutaTokenPoolChunk, anjuta_token_pool_chunks->len - 1).first < chunk.first))
+			{
+				g_array_append_val (anjuta_token_pool_chunks, chunk);
+			}
+			else
+			{
+				g_array_insert_val (anjuta_token_pool_chunks, anjuta_token_pool_find_chunk (chunk.first) + 1, chunk);
+			}
+		}
+		token = pool->next++;
+	}
+	pool->count++;
+
+	memset (token, 0, sizeof (AnjutaToken));
+	token->data.flags = ANJUTA_TOKEN_POOLED;
+
+	return token;
+}
+
+/* Allocate a new token in the current pool if there is one. Do not use it
+ * for tokens owning their string, as the pool does not free them. */
+static AnjutaToken *
+anjuta_token_alloc (void)
+{
+	if (anjuta_token_pool_stack == NULL)
+	{
+		return g_slice_new0 (AnjutaToken);
+	}
+	else
+	{
+		return anjuta_token_pool_alloc ((AnjutaTokenPool *)anjuta_token_pool_stack->data);
+	}
+}
+
 /* Private functions
  *---------------------------------------------------------------------------*/
 
@@ -153,17 +313,17 @@ anjuta_token_copy (AnjutaToken *token)
 
 	if (token != NULL)
 	{
-		copy = g_slice_new0 (AnjutaToken);
-		copy->data.type = token->data.type;
-		copy->data.flags = token->data.flags;
-		if ((copy->data.flags & ANJUTA_TOKEN_STATIC) || (token->data.pos == NULL))
+		if ((token->data.flags & ANJUTA_TOKEN_STATIC) || (token->data.pos == NULL))
 		{
+			copy = anjuta_token_alloc ();
 			copy->data.pos = token->data.pos;
 		}
 		else
 		{
+			copy = g_slice_new0 (AnjutaToken);
 			copy->data.pos = g_strdup (token->data.pos);
 		}
+		copy->data.flags |= token->data.flags & ~(ANJUTA_TOKEN_POOLED | ANJUTA_TOKEN_PADDED);
 		copy->data.length = token->data.length;
 	}
 
@@ -314,13 +474,13 @@ anjuta_token_check_child (AnjutaToken *token, AnjutaToken *parent)
 void
 anjuta_token_set_type (AnjutaToken *token, gint type)
 {
-	token->data.type = type;
+	token->data.flags = (token->data.flags & ANJUTA_TOKEN_FLAGS) | (type & ANJUTA_TOKEN_TYPE);
 }
 
 gint
 anjuta_token_get_type (AnjutaToken *token)
 {
-	return token->data.type;
+	return ANJUTA_TOKEN_DATA_TYPE (token);
 }
 
 void
@@ -331,20 +491,20 @@ anjuta_token_set_flags (AnjutaToken *token, gint flags)
 	
 	for (child = token; child != NULL; child = anjuta_token_next_child (child, &last))
 	{
-		child->data.flags |= flags;
+		child->data.flags |= flags & ANJUTA_TOKEN_FLAGS;
 	}
 }
 
 void
 anjuta_token_clear_flags (AnjutaToken *token, gint flags)
 {
-	token->data.flags &= ~flags;
+	token->data.flags &= ~(flags & ANJUTA_TOKEN_FLAGS & ~ANJUTA_TOKEN_POOLED);
 }
 
 gint
 anjuta_token_get_flags (AnjutaToken *token)
 {
-	return token->data.flags;
+	return token->data.flags & ANJUTA_TOKEN_FLAGS;
 }
 
 void
@@ -355,6 +515,7 @@ anjuta_token_set_string (AnjutaToken *token, const gchar *data, guint length)
 		g_free (token->data.pos);
 		token->data.flags |= ANJUTA_TOKEN_STATIC;
 	}
+	token->data.flags &= ~ANJUTA_TOKEN_PADDED;
 	token->data.pos = (gchar *)data;
 	token->data.length = length;
 }
@@ -1027,12 +1188,12 @@ anjuta_token_evaluate (AnjutaToken *token)
 gboolean
 anjuta_token_compare (AnjutaToken *toka, AnjutaToken *tokb)
 {
-	if (tokb->data.type)
+	if (ANJUTA_TOKEN_DATA_TYPE (tokb))
 	{
-		if (tokb->data.type != toka->data.type) return FALSE;
+		if (ANJUTA_TOKEN_DATA_TYPE (tokb) != ANJUTA_TOKEN_DATA_TYPE (toka)) return FALSE;
 	}
 	
-	if (tokb->data.type != ANJUTA_TOKEN_NONE)
+	if (ANJUTA_TOKEN_DATA_TYPE (tokb) != ANJUTA_TOKEN_NONE)
 	{
 		if (tokb->data.length != 0)
 		{
@@ -1127,11 +1288,15 @@ AnjutaToken *anjuta_token_new_string (AnjutaTokenType type, const gchar *value)
 	}
 	else
 	{
+		gsize length = strlen (value);
+
+		/* Token length is stored on 32 bits */
+		g_return_val_if_fail (length <= G_MAXUINT32, NULL);
+
 		token = g_slice_new0 (AnjutaToken);
-		token->data.type = type  & ANJUTA_TOKEN_TYPE;
-		token->data.flags = type & ANJUTA_TOKEN_FLAGS;
+		token->data.flags = type;
 		token->data.pos = g_strdup (value);
-		token->data.length = strlen (value);
+		token->data.length = length;
 	}
 
 	return token;
@@ -1148,9 +1313,10 @@ anjuta_token_new_with_string (AnjutaTokenType type, gchar *value, gsize length)
 	}
 	else
 	{
+		g_return_val_if_fail (length <= G_MAXUINT32, NULL);
+
 		token = g_slice_new0 (AnjutaToken);
-		token->data.type = type  & ANJUTA_TOKEN_TYPE;
-		token->data.flags = type & ANJUTA_TOKEN_FLAGS;
+		token->data.flags = type;
 		token->data.pos = value;
 		token->data.length = length;
 	}
@@ -1158,18 +1324,23 @@ anjuta_token_new_with_string (AnjutaTokenType type, gchar *value, gsize length)
 	return token;
 }
 
-AnjutaToken *
-anjuta_token_new_fragment (gint type, const gchar *pos, gsize length)
+/* The length has to be checked before allocating the token */
+static AnjutaToken *
+anjuta_token_init_fragment (AnjutaToken *token, gint type, const gchar *pos, gsize length)
 {
-	AnjutaToken *token;
-
-	token = g_slice_new0 (AnjutaToken);
-	token->data.type = type  & ANJUTA_TOKEN_TYPE;
-	token->data.flags = (type & ANJUTA_TOKEN_FLAGS) | ANJUTA_TOKEN_STATIC;
+	token->data.flags |= (type & ~ANJUTA_TOKEN_POOLED) | ANJUTA_TOKEN_STATIC;
 	token->data.pos = (gchar *)pos;
 	token->data.length = length;
 
 	return token;
+}
+
+AnjutaToken *
+anjuta_token_new_fragment (gint type, const gchar *pos, gsize length)
+{
+	g_return_val_if_fail (length <= G_MAXUINT32, NULL);
+
+	return anjuta_token_init_fragment (anjuta_token_alloc (), type, pos, length);
 };
 
 AnjutaToken *anjuta_token_new_static (AnjutaTokenType type, const char *value)
@@ -1207,9 +1378,16 @@ AnjutaToken*
 anjuta_token_free (AnjutaToken *token)
 {
 	AnjutaToken *next;
+	AnjutaTokenPool *pool;
 	
 	if (token == NULL) return NULL;
 
+	/* Find the pool using only the token address, the token memory is not
+	 * valid anymore if it belongs to a released pool */
+	pool = anjuta_token_pool_lookup (token);
+	g_return_val_if_fail ((pool != NULL) || !(token->data.flags & ANJUTA_TOKEN_POOLED), NULL);
+	g_return_val_if_fail ((pool == NULL) || (pool->thread == g_thread_self ()), NULL);
+
 	anjuta_token_free_children (token);
 
 	next = anjuta_token_next (token);
@@ -1218,7 +1396,374 @@ anjuta_token_free (AnjutaToken *token)
 	{
 		g_free (token->data.pos);
 	}
-	g_slice_free (AnjutaToken, token);
+	if (!(token->data.flags & ANJUTA_TOKEN_POOLED))
+	{
+		g_slice_free (AnjutaToken, token);
+	}
+	else
+	{
+		/* Keep pooled token memory for the next token of the same pool */
+		token->next = pool->released;
+		pool->released = token;
+		pool->count--;
+	}
 
 	return next;
 }
+
+/* Token pool
+ *---------------------------------------------------------------------------*/
+
+/**
+ * anjuta_token_pool_new:
+ *
+ * Create a new empty token pool. It can be used only in the current thread.
+ *
+ * Return value: The newly created pool.
+ */
+AnjutaTokenPool *
+anjuta_token_pool_new (void)
+{
+	AnjutaTokenPool *pool;
+
+	pool = g_slice_new0 (AnjutaTokenPool);
+	pool->thread = g_thread_self ();
+
+	return pool;
+}
+
+/**
+ * anjuta_token_pool_free:
+ * @pool: a #AnjutaTokenPool object.
+ *
+ * Release at once all tokens allocated in the pool. These tokens must not be
+ * used afterward. The pool must not be active.
+ */
+void
+anjuta_token_pool_free (AnjutaTokenPool *pool)
+{
+	if (pool == NULL) return;
+
+	g_return_if_fail (pool->thread == g_thread_self ());
+	g_return_if_fail (g_slist_find (anjuta_token_pool_stack, pool) == NULL);
+
+	if (anjuta_token_pool_chunks != NULL)
+	{
+		guint i;
+		guint j;
+
+		/* Remove memory blocks of this pool, keeping the order */
+		for (i = 0, j = 0; i < anjuta_token_pool_chunks->len; i++)
+		{
+			AnjutaTokenPoolChunk *chunk = &g_array_index (anjuta_token_pool_chunks, AnjutaTokenPoolChunk, i);
+
+			if (chunk->pool != pool)
+			{
+				g_array_index (anjuta_token_pool_chunks, AnjutaTokenPoolChunk, j) = *chunk;
+				j++;
+			}
+		}
+		g_array_set_size (anjuta_token_pool_chunks, j);
+	}
+
+	g_slist_foreach (pool->chunks, (GFunc)g_free, NULL);
+	g_slist_free (pool->chunks);
+	g_slice_free (AnjutaTokenPool, pool);
+}
+
+/**
+ * anjuta_token_pool_push:
+ * @pool: a #AnjutaTokenPool object.
+ *
+ * Make @pool the active pool: all tokens created afterward, except the ones
+ * owning their string, are allocated in it. The previous pool is restored
+ * by anjuta_token_pool_pop().
+ */
+void
+anjuta_token_pool_push (AnjutaTokenPool *pool)
+{
+	g_return_if_fail (pool != NULL);
+	g_return_if_fail (pool->thread == g_thread_self ());
+
+	anjuta_token_pool_stack = g_slist_prepend (anjuta_token_pool_stack, pool);
+}
+
+/**
+ * anjuta_token_pool_pop:
+ *
+ * Deactivate the current pool and restore the previous one.
+ *
+ * Return value: The deactivated pool.
+ */
+AnjutaTokenPool *
+anjuta_token_pool_pop (void)
+{
+	AnjutaTokenPool *pool;
+
+	g_return_val_if_fail (anjuta_token_pool_stack != NULL, NULL);
+
+	pool = (AnjutaTokenPool *)anjuta_token_pool_stack->data;
+	g_return_val_if_fail (pool->thread == g_thread_self (), NULL);
+	anjuta_token_pool_stack = g_slist_delete_link (anjuta_token_pool_stack, anjuta_token_pool_stack);
+
+	return pool;
+}
+
+/**
+ * anjuta_token_pool_new_fragment:
+ * @pool: a #AnjutaTokenPool object.
+ * @type: a token type.
+ * @pos: a pointer on the token characters.
+ * @length: the token length.
+ *
+ * Create a new token like anjuta_token_new_fragment() but allocated in @pool
+ * even if it is not the active pool.
+ *
+ * Return value: The newly created token.
+ */
+AnjutaToken *
+anjuta_token_pool_new_fragment (AnjutaTokenPool *pool, gint type, const gchar *pos, gsize length)
+{
+	g_return_val_if_fail (pool != NULL, NULL);
+	g_return_val_if_fail (length <= G_MAXUINT32, NULL);
+
+	return anjuta_token_init_fragment (anjuta_token_pool_alloc (pool), type, pos, length);
+}
+
+/**
+ * anjuta_token_pool_get_count:
+ * @pool: a #AnjutaTokenPool object.
+ *
+ * Return value: The number of tokens allocated in @pool and not freed.
+ */
+guint
+anjuta_token_pool_get_count (AnjutaTokenPool *pool)
+{
+	return pool->count;
+}
+
+/* Token tree snapshot
+ *---------------------------------------------------------------------------*/
+
+/* Number of links saved for each token */
+#define ANJUTA_TOKEN_LINKS	6
+
+/* A token saved in a snapshot, links are indexes in the token array, -1 for
+ * NULL. The characters are either in the file content at offset or in the
+ * string table at string. */
+typedef struct _AnjutaTokenRecord
+{
+	gint32 flags;
+	guint32 length;
+	gint32 offset;
+	gint32 string;
+	gint32 links[ANJUTA_TOKEN_LINKS];
+} AnjutaTokenRecord;
+
+/* Header of a snapshot, followed by the token records and the string table */
+typedef struct _AnjutaTokenSnapshot
+{
+	guint32 count;
+	guint32 string_size;
+} AnjutaTokenSnapshot;
+
+static AnjutaToken **
+anjuta_token_get_links (AnjutaToken *token, AnjutaToken **links)
+{
+	links[0] = token->next;
+	links[1] = token->prev;
+	links[2] = token->parent;
+	links[3] = token->last;
+	links[4] = token->group;
+	links[5] = token->children;
+
+	return links;
+}
+
+/**
+ * anjuta_token_save_tree:
+ * @root: root token of the tree.
+ * @content: file content.
+ * @length: length of @content.
+ * @indexes: a hash table filled with the index + 1 of each token.
+ *
+ * Save a token tree in a memory block, which can be written on disk and
+ * loaded later with anjuta_token_load_tree(). Tokens pointing inside
+ * @content keep only an offset, so the content has to be available when
+ * loading the tree. The tree must not have links to tokens outside itself.
+ *
+ * Return value: The snapshot data or NULL if the tree cannot be saved.
+ */
+GByteArray *
+anjuta_token_save_tree (AnjutaToken *root, const gchar *content, gsize length, GHashTable *indexes)
+{
+	GPtrArray *tokens;
+	GString *strings;
+	GByteArray *data;
+	AnjutaTokenSnapshot header;
+	AnjutaToken *token;
+	guint i;
+
+	g_return_val_if_fail ((root != NULL) && (indexes != NULL), NULL);
+
+	tokens = g_ptr_array_new ();
+	for (token = root; token != NULL; token = anjuta_token_next (token))
+	{
+		g_ptr_array_add (tokens, token);
+		g_hash_table_insert (indexes, token, GUINT_TO_POINTER (tokens->len));
+	}
+
+	strings = g_string_new (NULL);
+	data = g_byte_array_sized_new (sizeof (header) + tokens->len * sizeof (AnjutaTokenRecord));
+	header.count = tokens->len;
+	header.string_size = 0;
+	g_byte_array_append (data, (const guint8 *)&header, sizeof (header));
+	for (i = 0; i < tokens->len; i++)
+	{
+		AnjutaTokenRecord record;
+		AnjutaToken *links[ANJUTA_TOKEN_LINKS];
+		gint j;
+
+		token = (AnjutaToken *)g_ptr_array_index (tokens, i);
+		record.flags = token->data.flags & ~(ANJUTA_TOKEN_POOLED | ANJUTA_TOKEN_STATIC);
+		record.length = token->data.length;
+		record.offset = -1;
+		record.string = -1;
+		if (token->data.pos == NULL)
+		{
+			record.length = 0;
+		}
+		else if ((token->data.pos >= content) && (token->data.pos + token->data.length <= content + length))
+		{
+			record.offset = token->data.pos - content;
+		}
+		else
+		{
+			record.string = strings->len;
+			g_string_append_len (strings, token->data.pos, token->data.length);
+			g_string_append_c (strings, '\0');
+		}
+
+		anjuta_token_get_links (token, links);
+		for (j = 0; j < ANJUTA_TOKEN_LINKS; j++)
+		{
+			if (links[j] == NULL)
+			{
+				record.links[j] = -1;
+			}
+			else
+			{
+				record.links[j] = GPOINTER_TO_UINT (g_hash_table_lookup (indexes, links[j])) - 1;
+				if (record.links[j] == -1) break;
+			}
+		}
+		if (j != ANJUTA_TOKEN_LINKS)
+		{
+			/* Link to a token outside the tree */
+			g_byte_array_free (data, TRUE);
+			data = NULL;
+			break;
+		}
+		g_byte_array_append (data, (const guint8 *)&record, sizeof (record));
+	}
+
+	if (data != NULL)
+	{
+		/* Keep the size a multiple of 4 bytes, so data written after the
+		 * snapshot stays aligned */
+		while (strings->len % sizeof (gint32)) g_string_append_c (strings, '\0');
+		g_byte_array_append (data, (const guint8 *)strings->str, strings->len);
+		((AnjutaTokenSnapshot *)data->data)->string_size = strings->len;
+	}
+
+	g_string_free (strings, TRUE);
+	g_ptr_array_free (tokens, TRUE);
+
+	return data;
+}
+
+/**
+ * anjuta_token_load_tree:
+ * @data: snapshot data created by anjuta_token_save_tree().
+ * @size: size of @data.
+ * @content: file content, it has to be the same than when saving.
+ * @length: length of @content.
+ * @count: returns the number of tokens.
+ *
+ * Create a token tree from a snapshot. The tokens are allocated in the active
+ * pool if there is one. The first token of the returned array is the root.
+ * @size is updated with the length of the snapshot data.
+ *
+ * Return value: A newly allocated array of all tokens or NULL if the
+ * snapshot is invalid.
+ */
+AnjutaToken **
+anjuta_token_load_tree (const gchar *data, gsize *size, gchar *content, gsize length, guint *count)
+{
+	const AnjutaTokenSnapshot *header;
+	const AnjutaTokenRecord *records;
+	const gchar *strings;
+	AnjutaToken **tokens;
+	guint i;
+
+	g_return_val_if_fail ((data != NULL) && (size != NULL), NULL);
+
+	if (*size < sizeof (AnjutaTokenSnapshot)) return NULL;
+	header = (const AnjutaTokenSnapshot *)data;
+	if ((header->count == 0) ||
+	    (header->count > (*size - sizeof (AnjutaTokenSnapshot)) / sizeof (AnjutaTokenRecord)) ||
+	    (header->string_size > *size - sizeof (AnjutaTokenSnapshot) - header->count * sizeof (AnjutaTokenRecord)))
+	{
+		return NULL;
+	}
+	records = (const AnjutaTokenRecord *)(header + 1);
+	strings = (const gchar *)(records + header->count);
+
+	/* Check all records before allocating anything */
+	for (i = 0; i < header->count; i++)
+	{
+		const AnjutaTokenRecord *record = &records[i];
+		gint j;
+
+		if ((record->offset != -1) && ((record->offset < 0) || ((gsize)record->offset + record->length > length))) return NULL;
+		if ((record->string != -1) && ((record->string < 0) || ((gsize)record->string + record->length >= header->string_size))) return NULL;
+		for (j = 0; j < ANJUTA_TOKEN_LINKS; j++)
+		{
+			if ((record->links[j] < -1) || (record->links[j] >= (gint32)header->count)) return NULL;
+		}
+	}
+
+	tokens = g_new (AnjutaToken *, header->count);
+	for (i = 0; i < header->count; i++)
+	{
+		const AnjutaTokenRecord *record = &records[i];
+
+		if (record->string != -1)
+		{
+			tokens[i] = g_slice_new0 (AnjutaToken);
+			tokens[i]->data.flags = record->flags;
+			tokens[i]->data.pos = g_strndup (strings + record->string, record->length);
+			tokens[i]->data.length = record->length;
+		}
+		else
+		{
+			tokens[i] = anjuta_token_init_fragment (anjuta_token_alloc (), record->flags, record->offset == -1 ? NULL : content + record->offset, record->length);
+		}
+	}
+	for (i = 0; i < header->count; i++)
+	{
+		const gint32 *links = records[i].links;
+
+		tokens[i]->next = links[0] == -1 ? NULL : tokens[links[0]];
+		tokens[i]->prev = links[1] == -1 ? NULL : tokens[links[1]];
+		tokens[i]->parent = links[2] == -1 ? NULL : tokens[links[2]];
+		tokens[i]->last = links[3] == -1 ? NULL : tokens[links[3]];
+		tokens[i]->group = links[4] == -1 ? NULL : tokens[links[4]];
+		tokens[i]->children = links[5] == -1 ? NULL : tokens[links[5]];
+	}
+
+	*size = sizeof (AnjutaTokenSnapshot) + header->count * sizeof (AnjutaTokenRecord) + header->string_size;
+	if (count != NULL) *count = header->count;
+
+	return tokens;
+}
@@ -80,11 +80,14 @@ typedef enum
 	ANJUTA_TOKEN_CASE_INSENSITIVE 		= 1 << 24,
 	ANJUTA_TOKEN_STATIC 							= 1 << 25,
 	ANJUTA_TOKEN_REMOVED						= 1 << 26,
-	ANJUTA_TOKEN_ADDED							= 1 << 27
+	ANJUTA_TOKEN_ADDED							= 1 << 27,
+	ANJUTA_TOKEN_POOLED							= 1 << 28,
+	ANJUTA_TOKEN_PADDED							= 1 << 29
 	
 } AnjutaTokenType;
 
 typedef struct _AnjutaToken AnjutaToken;
+typedef struct _AnjutaTokenPool AnjutaTokenPool;
 
 AnjutaToken *anjuta_token_new_string (AnjutaTokenType type, const gchar *value);
 AnjutaToken *anjuta_token_new_with_string (AnjutaTokenType type, gchar *value, gsize length);
@@ -136,6 +139,16 @@ void anjuta_token_dump_link (AnjutaToken *token);
 
 gboolean anjuta_token_compare (AnjutaToken *tokena, AnjutaToken *tokenb);
 
+AnjutaTokenPool *anjuta_token_pool_new (void);
+void anjuta_token_pool_free (AnjutaTokenPool *pool);
+void anjuta_token_pool_push (AnjutaTokenPool *pool);
+AnjutaTokenPool *anjuta_token_pool_pop (void);
+AnjutaToken *anjuta_token_pool_new_fragment (AnjutaTokenPool *pool, gint type, const gchar *pos, gsize length);
+guint anjuta_token_pool_get_count (AnjutaTokenPool *pool);
+
+GByteArray *anjuta_token_save_tree (AnjutaToken *root, const gchar *content, gsize length, GHashTable *indexes);
+AnjutaToken **anjuta_token_load_tree (const gchar *data, gsize *size, gchar *content, gsize length, guint *count);
+
 G_END_DECLS
 
 #endif
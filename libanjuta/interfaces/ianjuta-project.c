@@ -370,6 +370,60 @@ ianjuta_project_base_init (IAnjutaProjectIface* klass)
 			0,
 			NULL);
 
+		/**
+		* IAnjutaProject::node_added:
+		* @obj: Self
+		* @node: a #AnjutaProjectNode
+		* 
+		* This signal is emitted when a node is added to the project, its children are
+		* added too.
+		*/
+		g_signal_new ("node-added",
+			IANJUTA_TYPE_PROJECT,
+			G_SIGNAL_RUN_LAST,
+			G_STRUCT_OFFSET (IAnjutaProjectIface, node_added),
+			NULL, NULL,
+			libanjuta_iface_cclosure_marshal_VOID__POINTER,
+			G_TYPE_NONE,
+			1,
+			G_TYPE_POINTER);
+
+		/**
+		* IAnjutaProject::node_removed:
+		* @obj: Self
+		* @node: a #AnjutaProjectNode
+		* 
+		* This signal is emitted when a node is removed from the project, it is
+		* destroyed after the emission.
+		*/
+		g_signal_new ("node-removed",
+			IANJUTA_TYPE_PROJECT,
+			G_SIGNAL_RUN_LAST,
+			G_STRUCT_OFFSET (IAnjutaProjectIface, node_removed),
+			NULL, NULL,
+			libanjuta_iface_cclosure_marshal_VOID__POINTER,
+			G_TYPE_NONE,
+			1,
+			G_TYPE_POINTER);
+
+		/**
+		* IAnjutaProject::node_changed:
+		* @obj: Self
+		* @node: a #AnjutaProjectNode
+		* 
+		* This signal is emitted when the data or the properties of a node have
+		* changed.
+		*/
+		g_signal_new ("node-changed",
+			IANJUTA_TYPE_PROJECT,
+			G_SIGNAL_RUN_LAST,
+			G_STRUCT_OFFSET (IAnjutaProjectIface, node_changed),
+			NULL, NULL,
+			libanjuta_iface_cclosure_marshal_VOID__POINTER,
+			G_TYPE_NONE,
+			1,
+			G_TYPE_POINTER);
+
 
 		initialized = TRUE;
 	}
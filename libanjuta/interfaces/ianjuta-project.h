@@ -70,6 +70,9 @@ struct _IAnjutaProjectIface {
 	
 	/* Signal */
 	void (*project_updated) (IAnjutaProject *obj);
+	void (*node_added) (IAnjutaProject *obj, AnjutaProjectNode *node);
+	void (*node_removed) (IAnjutaProject *obj, AnjutaProjectNode *node);
+	void (*node_changed) (IAnjutaProject *obj, AnjutaProjectNode *node);
 
 	AnjutaProjectGroup* (*add_group) (IAnjutaProject *obj, AnjutaProjectGroup *parent,  const gchar *name, GError **err);
 	AnjutaProjectSource* (*add_source) (IAnjutaProject *obj, AnjutaProjectTarget *parent,  GFile *file, GError **err);
@@ -24,10 +24,13 @@
 
 #include "am-project.h"
 
+#include <libanjuta/anjuta-string-pool.h>
+#include <libanjuta/anjuta-project-arena.h>
+
 G_BEGIN_DECLS
 
 struct _AmpPackage {
-    gchar *name;
+    const gchar *name;			/* Interned in project strings */
     gchar *version;
 };
 
@@ -76,15 +79,41 @@ struct _AmpProject {
 								 * AmpNode, and the root of
 								 * the tree is the root group. */
 
+	/* names used as hash table keys, kept until the project is unloaded */
+	AnjutaStringPool	*strings;
+
+	/* data of all nodes, allocated contiguously by type */
+	AnjutaProjectArena	*nodes;
+
+	/* directory of parsed makefile snapshots or NULL */
+	gchar			*snapshot_directory;
+
 	/* shortcut hash tables, mapping id -> GNode from the tree above */
 	GHashTable		*groups;
 	GHashTable		*files;
 	GHashTable		*configs;		/* Config file from configure_file */
 	
 	GHashTable	*modules;
+
+	/* handles given to targets and sources */
+	GArray			*handles;		/* Handle index -> AmpNodeHandle */
+	GHashTable		*node_handles;	/* Node -> handle */
+	guint			free_handle;		/* Index + 1 of first free handle or 0 */
 	
 	/* project files monitors */
 	GHashTable         *monitors;
+	GHashTable		*dirty;			/* Changed files -> deleted flag */
+	guint			dirty_timeout;		/* Pending update source id */
+	GTimeVal		dirty_since;		/* Time of the first pending event */
+	guint			monitor_delay;		/* Quiet time before update in ms */
+	guint			monitor_events;		/* Number of events received */
+	guint			monitor_reloads;	/* Number of files or project reloaded */
+
+	/* makefiles read in advance by other threads while loading */
+	GThreadPool		*prefetch_pool;
+	GHashTable		*prefetch;		/* Directory uri -> AmpPrefetch */
+	GMutex			*prefetch_lock;
+	GCond			*prefetch_cond;
 
 	/* Keep list style */
 	AnjutaTokenStyle *ac_space_list;
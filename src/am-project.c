@@ -31,6 +31,7 @@
 #include <libanjuta/interfaces/ianjuta-project.h>
 #include <libanjuta/anjuta-debug.h>
 #include <libanjuta/anjuta-utils.h>
+#include <libanjuta/anjuta-directory-cache.h>
 
 #include <string.h>
 #include <memory.h>
@@ -47,6 +48,7 @@
 #include "ac-scanner.h"
 #include "ac-writer.h"
 #include "am-scanner.h"
+#include "am-snapshot.h"
 #include "am-dialogs.h"
 #include "am-writer.h"
 //#include "am-config.h"
@@ -62,6 +64,17 @@
 
 static const gchar *valid_am_makefiles[] = {"GNUmakefile.am", "makefile.am", "Makefile.am", NULL};
 
+/* Number of threads used to read makefiles in advance */
+#define AMP_PREFETCH_THREADS	4
+
+/* Default time in milliseconds without monitor event before updating the
+ * project */
+#define AMP_MONITOR_DELAY	250
+
+/* Maximum number of monitor delays before updating the project if events are
+ * received continuously */
+#define AMP_MONITOR_MAX_DELAYS	4
+
 /* convenient shortcut macro the get the AnjutaProjectNode from a GNode */
 #define AMP_NODE_DATA(node)  ((node) != NULL ? (AnjutaProjectNodeData *)((node)->data) : NULL)
 #define AMP_GROUP_DATA(node)  ((node) != NULL ? (AmpGroupData *)((node)->data) : NULL)
@@ -93,6 +106,9 @@ struct _AmpGroupData {
 	AnjutaTokenFile *tfile;		/* Corresponding Makefile */
 	GList *tokens[AM_GROUP_TOKEN_LAST];					/* List of token used by this group */
 	AnjutaToken *make_token;
+	GArray *variables;			/* Automake variables found in makefile, in order */
+	GHashTable *targets;			/* Target name -> target, built when needed */
+	GHashTable *canonical_targets;	/* Canonical target name -> target */
 };
 
 typedef enum _AmpTargetFlag
@@ -123,6 +139,16 @@ struct _AmpSourceData {
 	AnjutaToken* token;
 };
 
+typedef struct _AmpPrefetch AmpPrefetch;
+
+struct _AmpPrefetch {
+	GFile *directory;
+	GFileType type[G_N_ELEMENTS (valid_am_makefiles)];	/* Type of each valid makefile name */
+	gchar *content[G_N_ELEMENTS (valid_am_makefiles)];	/* Content of regular files */
+	gsize length[G_N_ELEMENTS (valid_am_makefiles)];
+	gboolean done;
+};
+
 typedef struct _AmpConfigFile AmpConfigFile;
 
 struct _AmpConfigFile {
@@ -319,32 +345,8 @@ get_relative_path (GFile *parent, GFile *file)
 static GFileType
 file_type (GFile *file, const gchar *filename)
 {
-	GFile *child;
-	GFileInfo *info;
-	GFileType type;
-
-	child = filename != NULL ? g_file_get_child (file, filename) : g_object_ref (file);
-
-	//g_message ("check file %s", g_file_get_path (child));
-	
-	info = g_file_query_info (child,
-	                          G_FILE_ATTRIBUTE_STANDARD_TYPE, 
-	                          G_FILE_QUERY_INFO_NONE,
-	                          NULL,
-	                          NULL);
-	if (info != NULL)
-	{
-		type = g_file_info_get_file_type (info);
-		g_object_unref (info);
-	}
-	else
-	{
-		type = G_FILE_TYPE_UNKNOWN;
-	}
-	
-	g_object_unref (child);
-	
-	return type;
+	/* Use the directory cache, a directory is read only once */
+	return anjuta_directory_cache_get_file_type (file, filename);
 }
 
 /* Automake parsing function
@@ -549,6 +551,138 @@ amp_config_file_free (AmpConfigFile *config)
 	}
 }
 
+/* Prefetched makefile objects
+ *---------------------------------------------------------------------------*/
+
+/* While loading a project, makefiles of sub directories are read by a thread
+ * pool as soon as they are found in a SUBDIRS variable. The parsing is still
+ * done in the main thread in the same order, it just does not wait for the
+ * file system anymore. */
+
+static AmpPrefetch*
+amp_prefetch_new (GFile *directory)
+{
+	AmpPrefetch *prefetch;
+
+	prefetch = g_slice_new0 (AmpPrefetch);
+	prefetch->directory = g_object_ref (directory);
+
+	return prefetch;
+}
+
+static void
+amp_prefetch_free (AmpPrefetch *prefetch)
+{
+	gint i;
+	
+	for (i = 0; i < G_N_ELEMENTS (valid_am_makefiles); i++)
+	{
+		g_free (prefetch->content[i]);
+	}
+	g_object_unref (prefetch->directory);
+	g_slice_free (AmpPrefetch, prefetch);
+}
+
+/* Called in a thread of the pool */
+static void
+amp_prefetch_run (AmpPrefetch *prefetch, AmpProject *project)
+{
+	gint i;
+
+	for (i = 0; valid_am_makefiles[i] != NULL; i++)
+	{
+		prefetch->type[i] = file_type (prefetch->directory, valid_am_makefiles[i]);
+		if (prefetch->type[i] == G_FILE_TYPE_REGULAR)
+		{
+			GFile *makefile = g_file_get_child (prefetch->directory, valid_am_makefiles[i]);
+
+			if (!g_file_load_contents (makefile, NULL, &prefetch->content[i], &prefetch->length[i], NULL, NULL))
+			{
+				prefetch->content[i] = NULL;
+			}
+			g_object_unref (makefile);
+		}
+	}
+
+	g_mutex_lock (project->prefetch_lock);
+	prefetch->done = TRUE;
+	g_cond_broadcast (project->prefetch_cond);
+	g_mutex_unlock (project->prefetch_lock);
+}
+
+static void
+amp_project_start_prefetch (AmpProject *project)
+{
+	if (!g_thread_supported ()) return;
+	
+	project->prefetch_lock = g_mutex_new ();
+	project->prefetch_cond = g_cond_new ();
+	project->prefetch = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify)amp_prefetch_free);
+	project->prefetch_pool = g_thread_pool_new ((GFunc)amp_prefetch_run, project, AMP_PREFETCH_THREADS, FALSE, NULL);
+}
+
+static void
+amp_project_stop_prefetch (AmpProject *project)
+{
+	if (project->prefetch_pool == NULL) return;
+
+	/* Wait for all remaining threads */
+	g_thread_pool_free (project->prefetch_pool, FALSE, TRUE);
+	project->prefetch_pool = NULL;
+	g_hash_table_destroy (project->prefetch);
+	project->prefetch = NULL;
+	g_cond_free (project->prefetch_cond);
+	project->prefetch_cond = NULL;
+	g_mutex_free (project->prefetch_lock);
+	project->prefetch_lock = NULL;
+}
+
+static void
+amp_project_queue_prefetch (AmpProject *project, GFile *directory)
+{
+	gchar *uri;
+	
+	if (project->prefetch_pool == NULL) return;
+
+	uri = g_file_get_uri (directory);
+	g_mutex_lock (project->prefetch_lock);
+	if (g_hash_table_lookup (project->prefetch, uri) == NULL)
+	{
+		AmpPrefetch *prefetch = amp_prefetch_new (directory);
+		
+		g_hash_table_insert (project->prefetch, uri, prefetch);
+		g_thread_pool_push (project->prefetch_pool, prefetch, NULL);
+		uri = NULL;
+	}
+	g_mutex_unlock (project->prefetch_lock);
+	g_free (uri);
+}
+
+/* Return prefetched data for directory, waiting for them if needed. The caller
+ * has to free it. */
+static AmpPrefetch*
+amp_project_wait_prefetch (AmpProject *project, GFile *directory)
+{
+	AmpPrefetch *prefetch = NULL;
+	gpointer key;
+	gchar *uri;
+
+	if (project->prefetch_pool == NULL) return NULL;
+
+	uri = g_file_get_uri (directory);
+	g_mutex_lock (project->prefetch_lock);
+	if (g_hash_table_lookup_extended (project->prefetch, uri, &key, (gpointer *)&prefetch))
+	{
+		while (!prefetch->done) g_cond_wait (project->prefetch_cond, project->prefetch_lock);
+		g_hash_table_steal (project->prefetch, uri);
+		g_free (key);
+	}
+	g_mutex_unlock (project->prefetch_lock);
+	g_free (uri);
+
+	return prefetch;
+}
+
 /* Package objects
  *---------------------------------------------------------------------------*/
 
@@ -562,6 +696,7 @@ amp_package_set_version (AmpPackage *package, const gchar *compare, const gchar
 	package->version = version != NULL ? g_strconcat (compare, version, NULL) : NULL;
 }
 
+/* The name has to be interned in the project strings */
 static AmpPackage*
 amp_package_new (const gchar *name)
 {
@@ -570,7 +705,7 @@ amp_package_new (const gchar *name)
 	g_return_val_if_fail (name != NULL, NULL);
 	
 	package = g_slice_new0(AmpPackage); 
-	package->name = g_strdup (name);
+	package->name = name;
 
 	return package;
 }
@@ -580,7 +715,6 @@ amp_package_free (AmpPackage *package)
 {
 	if (package)
 	{
-		g_free (package->name);
 		g_free (package->version);
 		g_slice_free (AmpPackage, package);
 	}
@@ -613,7 +747,7 @@ amp_module_free (AmpModule *module)
 static void
 amp_project_new_module_hash (AmpProject *project)
 {
-	project->modules = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify)amp_module_free);
+	project->modules = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify)amp_module_free);
 }
 
 static void
@@ -671,8 +805,9 @@ amp_group_set_dist_only (AmpGroup *node, gboolean dist_only)
  	AMP_GROUP_DATA (node)->dist_only = dist_only;
 }
 
+/* If content is not NULL, it is used instead of reading makefile */
 static AnjutaTokenFile*
-amp_group_set_makefile (AmpGroup *node, GFile *makefile, AmpProject* project)
+amp_group_set_makefile (AmpGroup *node, GFile *makefile, gchar *content, gsize length, AmpProject* project)
 {
     AmpGroupData *group;
 	
@@ -689,30 +824,355 @@ amp_group_set_makefile (AmpGroup *node, GFile *makefile, AmpProject* project)
 		group->makefile = g_object_ref (makefile);
 		group->tfile = anjuta_token_file_new (makefile);
 
-		token = anjuta_token_file_load (group->tfile, NULL);
+		if (content != NULL)
+		{
+			token = anjuta_token_file_load_data (group->tfile, content, length);
+		}
+		else
+		{
+			token = anjuta_token_file_load (group->tfile, NULL);
+		}
 			
+		anjuta_token_pool_push (anjuta_token_file_get_pool (group->tfile));
 		scanner = amp_am_scanner_new (project, node);
-		group->make_token = amp_am_scanner_parse_token (scanner, token, NULL);
+		group->make_token = amp_am_snapshot_load (scanner, project->snapshot_directory, makefile, token);
+		if (group->make_token == NULL)
+		{
+			group->make_token = amp_am_scanner_parse_token (scanner, token, NULL);
+			amp_am_snapshot_save (scanner, project->snapshot_directory, makefile, token, group->make_token);
+		}
+		if (group->variables != NULL) g_array_free (group->variables, TRUE);
+		group->variables = amp_am_scanner_steal_variables (scanner);
 		amp_am_scanner_free (scanner);
+		anjuta_token_pool_pop ();
 	}
 	else
 	{
 		group->makefile = NULL;
 		group->tfile = NULL;
 		group->make_token = NULL;
+		if (group->variables != NULL) g_array_free (group->variables, TRUE);
+		group->variables = NULL;
 	}
 
 	return group->tfile;
 }
 
+/* Append to offsets the position in the new content of all tokens below
+ * root pointing inside base, tokens after start are moved by delta
+ * characters */
+static void
+amp_group_save_token_offsets (AnjutaToken *root, const gchar *base, gsize start, gssize delta, GArray *offsets)
+{
+	AnjutaToken *token;
+
+	for (token = anjuta_token_next (root); token != NULL; token = anjuta_token_next (token))
+	{
+		const gchar *pos = anjuta_token_get_string (token);
+		gsize offset;
+
+		if (pos == NULL) continue;
+		offset = pos - base;
+		if (offset >= start) offset += delta;
+		g_array_append_val (offsets, offset);
+	}
+}
+
+/* Move all tokens below root to the offsets saved by
+ * amp_group_save_token_offsets in the new content, starting at index. Return
+ * the index of the first offset not used */
+static guint
+amp_group_restore_token_offsets (AnjutaToken *root, const gchar *new, GArray *offsets, guint index)
+{
+	AnjutaToken *token;
+
+	for (token = anjuta_token_next (root); token != NULL; token = anjuta_token_next (token))
+	{
+		if (anjuta_token_get_string (token) == NULL) continue;
+		anjuta_token_set_string (token, new + g_array_index (offsets, gsize, index), anjuta_token_get_length (token));
+		index++;
+	}
+
+	return index;
+}
+
+/* Return TRUE if the logical lines in text do not contain a conditional or a
+ * rule. The statements around them depend on these lines, so they cannot be
+ * parsed alone */
+static gboolean
+amp_group_is_plain_text (const gchar *text, gsize length)
+{
+	static const gchar *keywords[] = {"if", "ifdef", "ifndef", "ifeq", "ifneq", "else", "endif", NULL};
+	const gchar *end = text + length;
+	const gchar *ptr;
+
+	for (ptr = text; ptr < end;)
+	{
+		const gchar *word;
+		const gchar **keyword;
+
+		/* Commands of a rule start with a tab */
+		if (*ptr == '\t') return FALSE;
+
+		/* Look for a conditional keyword */
+		for (; (ptr < end) && ((*ptr == ' ') || (*ptr == '\t')); ptr++);
+		for (word = ptr; (ptr < end) && (g_ascii_isalnum (*ptr) || (*ptr == '_')); ptr++);
+		for (keyword = keywords; *keyword != NULL; keyword++)
+		{
+			if ((strlen (*keyword) == (gsize)(ptr - word)) && (strncmp (*keyword, word, ptr - word) == 0)) return FALSE;
+		}
+
+		/* Look for a rule colon before any assignment */
+		for (; (ptr < end) && (*ptr != '\n') && (*ptr != '#') && (*ptr != '='); ptr++)
+		{
+			if ((*ptr == ':') && ((ptr + 1 == end) || (ptr[1] != '='))) return FALSE;
+			if ((*ptr == '\\') && (ptr + 1 < end)) ptr++;
+		}
+
+		/* Go to next logical line */
+		for (; (ptr < end) && (*ptr != '\n'); ptr++)
+		{
+			if ((*ptr == '\\') && (ptr + 1 < end)) ptr++;
+		}
+		ptr++;
+	}
+
+	return TRUE;
+}
+
+/* Return the last token of the statements parsed in root if it is an end of
+ * line */
+static AnjutaToken *
+amp_group_get_last_eol (AnjutaToken *root)
+{
+	AnjutaToken *token;
+	AnjutaToken *last = NULL;
+
+	for (token = anjuta_token_next (root); token != NULL; token = anjuta_token_next (token))
+	{
+		if (anjuta_token_parent (token) == root) last = token;
+	}
+
+	return (last != NULL) && (anjuta_token_get_type (last) == ANJUTA_TOKEN_EOL) ? last : NULL;
+}
+
+/* Parse again only the statements of the makefile changed in content, then
+ * replay all automake variables to create the group children. Return FALSE
+ * without using content if the whole makefile has to be parsed. */
+static gboolean
+amp_group_update_makefile (AmpGroup *node, gchar *content, gsize length, AmpProject *project)
+{
+	AmpGroupData *group = AMP_GROUP_DATA (node);
+	AnjutaToken *root;
+	AnjutaToken *frag;
+	AnjutaToken *token;
+	AnjutaToken *first = NULL;		/* Last end of line before the change */
+	AnjutaToken *last = NULL;		/* First end of line after the change */
+	AnjutaToken *stop;
+	AnjutaToken *parsed = NULL;
+	AmpAmScanner *scanner;
+	GArray *found = NULL;
+	GArray *variables;
+	GArray *offsets;
+	const gchar *old;
+	const gchar *new;
+	gsize old_length;
+	gsize prefix;
+	gsize suffix;
+	gsize start;
+	gsize end;
+	gssize delta;
+	guint i;
+
+	if ((group->tfile == NULL) || (group->make_token == NULL) || (group->variables == NULL) || (content == NULL)) return FALSE;
+	root = group->make_token;
+
+	/* Only an unmodified content can be updated */
+	frag = anjuta_token_next (anjuta_token_file_get_content (group->tfile));
+	if ((frag == NULL) || (anjuta_token_next (frag) != NULL)) return FALSE;
+	if (!(anjuta_token_get_flags (frag) & ANJUTA_TOKEN_PADDED)) return FALSE;
+	old = anjuta_token_get_string (frag);
+	old_length = anjuta_token_get_length (frag);
+
+	/* Find changed characters */
+	for (prefix = 0; (prefix < old_length) && (prefix < length) && (old[prefix] == content[prefix]); prefix++);
+	for (suffix = 0; (suffix < old_length - prefix) && (suffix < length - prefix) && (old[old_length - suffix - 1] == content[length - suffix - 1]); suffix++);
+	delta = (gssize)length - (gssize)old_length;
+
+	/* Find the logical lines around the change, a line ending with a
+	 * backslash continues on the next one */
+	for (start = prefix; start > 0; start--)
+	{
+		if ((old[start - 1] == '\n') && ((start < 2) || (old[start - 2] != '\\'))) break;
+	}
+	for (end = old_length - suffix; end < old_length; end++)
+	{
+		if ((old[end] == '\n') &&
+		    ((end == 0) || (old[end - 1] != '\\')) &&
+		    ((end + delta == 0) || (content[end + delta - 1] != '\\')))
+		{
+			end++;
+			break;
+		}
+	}
+	if (end > old_length) end = old_length;
+
+	/* Conditionals and rules change the meaning of the following lines */
+	if (!amp_group_is_plain_text (old + start, end - start)) return FALSE;
+	if (!amp_group_is_plain_text (content + start, end + delta - start)) return FALSE;
+
+	/* Find the statement ends matching these lines */
+	for (token = anjuta_token_next (root); token != NULL; token = anjuta_token_next (token))
+	{
+		const gchar *pos = anjuta_token_get_string (token);
+		gsize offset;
+
+		if (pos == NULL) continue;
+		if ((pos < old) || (pos + anjuta_token_get_length (token) > old + old_length)) return FALSE;
+		if ((anjuta_token_get_type (token) != ANJUTA_TOKEN_EOL) || (anjuta_token_parent (token) != root)) continue;
+
+		offset = pos - old + anjuta_token_get_length (token);
+		if (offset == start)
+		{
+			first = token;
+		}
+		else if (offset == end)
+		{
+			last = token;
+		}
+	}
+	if (((start != 0) && (first == NULL)) || ((end != old_length) && (last == NULL))) return FALSE;
+
+	/* Parse changed statements in the new content, without updating the
+	 * project */
+	if (end + delta > start)
+	{
+		AnjutaToken *input;
+
+		input = anjuta_token_new_static (ANJUTA_TOKEN_FILE, NULL);
+		anjuta_token_prepend_child (input, anjuta_token_new_fragment (ANJUTA_TOKEN_FILE, content + start, end + delta - start));
+
+		anjuta_token_pool_push (anjuta_token_file_get_pool (group->tfile));
+		scanner = amp_am_scanner_new (project, node);
+		amp_am_scanner_set_record_only (scanner, TRUE);
+		parsed = amp_am_scanner_parse_token (scanner, input, NULL);
+		found = amp_am_scanner_steal_variables (scanner);
+		amp_am_scanner_free (scanner);
+		anjuta_token_pool_pop ();
+		anjuta_token_free (input);
+
+		if ((last != NULL) && ((token = amp_group_get_last_eol (parsed)) == NULL || (anjuta_token_get_string (token) + anjuta_token_get_length (token) != content + end + delta)))
+		{
+			/* The statements do not end at the same position */
+			anjuta_token_free (parsed);
+			g_array_free (found, TRUE);
+
+			return FALSE;
+		}
+	}
+
+	/* Keep variables outside the changed statements */
+	variables = g_array_new (FALSE, FALSE, sizeof (AmpAmVariable));
+	for (i = 0; i < group->variables->len; i++)
+	{
+		AmpAmVariable *var = &g_array_index (group->variables, AmpAmVariable, i);
+		gsize offset = anjuta_token_get_string (var->name) - old;
+
+		if ((offset >= end) && (found != NULL))
+		{
+			g_array_append_vals (variables, found->data, found->len);
+			g_array_free (found, TRUE);
+			found = NULL;
+		}
+		if ((offset < start) || (offset >= end)) g_array_append_val (variables, *var);
+	}
+	if (found != NULL)
+	{
+		g_array_append_vals (variables, found->data, found->len);
+		g_array_free (found, TRUE);
+	}
+
+	/* Remove changed statements */
+	stop = last != NULL ? anjuta_token_next (last) : NULL;
+	for (token = first != NULL ? anjuta_token_next (first) : anjuta_token_next (root); token != stop;)
+	{
+		token = anjuta_token_free (token);
+	}
+
+	/* The new content is reallocated when it is given to the file, so
+	 * keep only the token offsets */
+	offsets = g_array_new (FALSE, FALSE, sizeof (gsize));
+	amp_group_save_token_offsets (root, old, start, delta, offsets);
+	if (parsed != NULL) amp_group_save_token_offsets (parsed, content, G_MAXSIZE, 0, offsets);
+
+	frag = anjuta_token_file_replace_data (group->tfile, content, length);
+	if (frag == NULL)
+	{
+		/* The caller parses the whole makefile again, discarding all
+		 * tokens */
+		if (parsed != NULL) anjuta_token_free (parsed);
+		g_array_free (offsets, TRUE);
+		g_array_free (variables, TRUE);
+
+		return FALSE;
+	}
+	new = anjuta_token_get_string (frag);
+	i = amp_group_restore_token_offsets (root, new, offsets, 0);
+	if (parsed != NULL) amp_group_restore_token_offsets (parsed, new, offsets, i);
+	g_array_free (offsets, TRUE);
+
+	/* Insert new statements */
+	if (parsed != NULL)
+	{
+		if (anjuta_token_next (parsed) == NULL)
+		{
+			anjuta_token_free (parsed);
+		}
+		else
+		{
+			if (first != NULL)
+			{
+				anjuta_token_insert_after (first, parsed);
+			}
+			else if (stop != NULL)
+			{
+				anjuta_token_insert_before (stop, parsed);
+			}
+			else
+			{
+				anjuta_token_prepend_child (root, parsed);
+			}
+			anjuta_token_delete_parent (parsed);
+		}
+	}
+
+	/* Create nodes again from all variables, they can depend on each other */
+	anjuta_token_pool_push (anjuta_token_file_get_pool (group->tfile));
+	scanner = amp_am_scanner_new (project, node);
+	for (i = 0; i < variables->len; i++)
+	{
+		AmpAmVariable *var = &g_array_index (variables, AmpAmVariable, i);
+
+		amp_am_scanner_set_am_variable (scanner, var->variable, var->name, var->list);
+	}
+	amp_am_snapshot_save (scanner, project->snapshot_directory, group->makefile, anjuta_token_file_get_content (group->tfile), root);
+	g_array_free (group->variables, TRUE);
+	group->variables = amp_am_scanner_steal_variables (scanner);
+	amp_am_scanner_free (scanner);
+	anjuta_token_pool_pop ();
+	g_array_free (variables, TRUE);
+
+	return TRUE;
+}
+
 static AmpGroup*
-amp_group_new (GFile *file, gboolean dist_only)
+amp_group_new (AmpProject *project, GFile *file, gboolean dist_only)
 {
     AmpGroupData *group = NULL;
 
 	g_return_val_if_fail (file != NULL, NULL);
 	
-	group = g_slice_new0(AmpGroupData); 
+	group = anjuta_project_arena_alloc (project->nodes, ANJUTA_PROJECT_GROUP, sizeof (AmpGroupData)); 
 	group->base.node.type = ANJUTA_PROJECT_GROUP;
 	group->base.node.properties = amp_get_group_property_list();
 	group->base.directory = g_object_ref (file);
@@ -735,10 +1195,11 @@ amp_group_free (AmpGroup *node)
 	{
 		if (group->tokens[i] != NULL) g_list_free (group->tokens[i]);
 	}
-    g_slice_free (AmpGroupData, group);
-	
-
-	g_node_destroy (node);
+	if (group->variables != NULL) g_array_free (group->variables, TRUE);
+	if (group->targets != NULL) g_hash_table_destroy (group->targets);
+	if (group->canonical_targets != NULL) g_hash_table_destroy (group->canonical_targets);
+	anjuta_project_node_destroy (node);
+	anjuta_project_arena_release (group);
 }
 
 /* Target objects
@@ -768,11 +1229,11 @@ amp_target_get_token (AmpTarget *node)
 
 
 static AmpTarget*
-amp_target_new (const gchar *name, AnjutaProjectTargetType type, const gchar *install, gint flags)
+amp_target_new (AmpProject *project, const gchar *name, AnjutaProjectTargetType type, const gchar *install, gint flags)
 {
     AmpTargetData *target = NULL;
 
-	target = g_slice_new0(AmpTargetData); 
+	target = anjuta_project_arena_alloc (project->nodes, ANJUTA_PROJECT_TARGET, sizeof (AmpTargetData)); 
 	target->base.node.type = ANJUTA_PROJECT_TARGET;
 	target->base.node.properties = amp_get_target_property_list(type);
 	target->base.name = g_strdup (name);
@@ -791,23 +1252,25 @@ amp_target_free (AmpTarget *node)
     g_free (target->base.name);
 	anjuta_project_property_foreach (target->base.node.properties, (GFunc)amp_property_free, NULL);
     g_free (target->install);
-    g_slice_free (AmpTargetData, target);
-
-	g_node_destroy (node);
+	anjuta_project_node_destroy (node);
+	anjuta_project_arena_release (target);
 }
 
 /* Source objects
  *---------------------------------------------------------------------------*/
 
+/* The source file is created from the group directory when needed if a
+ * relative name is given, this name has to be interned in the project */
 static AmpSource*
-amp_source_new (GFile *file)
+amp_source_new (AmpProject *project, const gchar *name, GFile *file)
 {
     AmpSourceData *source = NULL;
 
-	source = g_slice_new0(AmpSourceData); 
+	source = anjuta_project_arena_alloc (project->nodes, ANJUTA_PROJECT_SOURCE, sizeof (AmpSourceData)); 
 	source->base.node.type = ANJUTA_PROJECT_SOURCE;
 	source->base.node.properties = amp_get_source_property_list();
-	source->base.file = g_object_ref (file);
+	source->base.name = name;
+	source->base.file = name == NULL ? g_object_ref (file) : NULL;
 
     return g_node_new (source);
 }
@@ -817,17 +1280,18 @@ amp_source_free (AmpSource *node)
 {
     AmpSourceData *source = AMP_SOURCE_DATA (node);
 	
-    g_object_unref (source->base.file);
+	if (source->base.file != NULL) g_object_unref (source->base.file);
 	anjuta_project_property_foreach (source->base.node.properties, (GFunc)amp_property_free, NULL);
-    g_slice_free (AmpSourceData, source);
-
-	g_node_destroy (node);
+	anjuta_project_node_destroy (node);
+	anjuta_project_arena_release (source);
 }
 
 /*
  * File monitoring support --------------------------------
  * FIXME: review these
  */
+static gboolean amp_project_refresh_dirty (gpointer data);
+
 static void
 monitor_cb (GFileMonitor *monitor,
 			GFile *file,
@@ -836,15 +1300,45 @@ monitor_cb (GFileMonitor *monitor,
 			gpointer data)
 {
 	AmpProject *project = data;
+	GFile *directory;
+	GTimeVal now;
 
 	g_return_if_fail (project != NULL && AMP_IS_PROJECT (project));
 
+	/* Directory content is changed */
+	directory = g_file_get_parent (file);
+	if (directory != NULL)
+	{
+		anjuta_directory_cache_invalidate (directory);
+		g_object_unref (directory);
+	}
+
 	switch (event_type) {
 		case G_FILE_MONITOR_EVENT_CHANGED:
 		case G_FILE_MONITOR_EVENT_DELETED:
-			/* monitor will be removed here... is this safe? */
-			amp_project_reload (project, NULL);
-			g_signal_emit_by_name (G_OBJECT (project), "project-updated");
+			/* Wait until no event is received during the monitor delay, but not
+			 * more than a few delays */
+			project->monitor_events++;
+			if ((event_type == G_FILE_MONITOR_EVENT_DELETED) || (g_hash_table_lookup (project->dirty, file) == NULL))
+			{
+				g_hash_table_replace (project->dirty, g_object_ref (file), GINT_TO_POINTER (event_type == G_FILE_MONITOR_EVENT_DELETED));
+			}
+			g_get_current_time (&now);
+			if (project->dirty_timeout == 0)
+			{
+				project->dirty_since = now;
+			}
+			else
+			{
+				glong elapsed;
+
+				/* Keep the pending update if it would be delayed more than
+				 * the maximum delay after the first event */
+				elapsed = (now.tv_sec - project->dirty_since.tv_sec) * 1000 + (now.tv_usec - project->dirty_since.tv_usec) / 1000;
+				if (elapsed + (glong)project->monitor_delay > (glong)project->monitor_delay * AMP_MONITOR_MAX_DELAYS) break;
+				g_source_remove (project->dirty_timeout);
+			}
+			project->dirty_timeout = g_timeout_add (project->monitor_delay, amp_project_refresh_dirty, project);
 			break;
 		default:
 			break;
@@ -871,10 +1365,22 @@ monitor_add (AmpProject *project, GFile *file)
 		exists = g_file_query_exists (file, NULL);
 		
 		if (exists) {
-			monitor = g_file_monitor_file (file, 
-						       G_FILE_MONITOR_NONE,
-						       NULL,
-						       NULL);
+			/* Group directories are monitored to get changes of
+			 * all their files */
+			if (file_type (file, NULL) == G_FILE_TYPE_DIRECTORY)
+			{
+				monitor = g_file_monitor_directory (file, 
+							       G_FILE_MONITOR_NONE,
+							       NULL,
+							       NULL);
+			}
+			else
+			{
+				monitor = g_file_monitor_file (file, 
+							       G_FILE_MONITOR_NONE,
+							       NULL,
+							       NULL);
+			}
 			if (monitor != NULL)
 			{
 				g_signal_connect (G_OBJECT (monitor),
@@ -897,6 +1403,11 @@ monitors_remove (AmpProject *project)
 	if (project->monitors)
 		g_hash_table_destroy (project->monitors);
 	project->monitors = NULL;
+
+	/* Drop pending events */
+	if (project->dirty_timeout != 0) g_source_remove (project->dirty_timeout);
+	project->dirty_timeout = 0;
+	if (project->dirty != NULL) g_hash_table_remove_all (project->dirty);
 }
 
 static void
@@ -946,7 +1457,7 @@ amp_dump_node (AnjutaProjectNode *g_node)
 			DEBUG_PRINT ("TARGET: %s", name);
 			break;
 		case ANJUTA_PROJECT_SOURCE:
-			name = g_file_get_uri (AMP_SOURCE_DATA (g_node)->base.file);
+			name = g_file_get_uri (anjuta_project_source_get_file (g_node));
 			DEBUG_PRINT ("SOURCE: %s", name);
 			break;
 		default:
@@ -956,27 +1467,141 @@ amp_dump_node (AnjutaProjectNode *g_node)
 	g_free (name);
 }
 
-static void
-foreach_node_destroy (AnjutaProjectNode    *g_node,
-		      gpointer  data)
+/* Targets and sources are identified outside the project by a 64 bits
+ * handle, an index in the handle table in the low 32 bits combined with a
+ * generation number incremented each time the entry is reused, so a stale
+ * handle is detected. An entry reaching the last generation is not reused
+ * anymore, so a generation never wraps. The handle index is attached to the
+ * node, it is kept when a makefile is loaded again if the node has not been
+ * removed. */
+
+#define AMP_HANDLE_INDEX_BITS 32
+#define AMP_HANDLE_INDEX_MASK G_GUINT64_CONSTANT (0xFFFFFFFF)
+
+typedef struct _AmpNodeHandle AmpNodeHandle;
+
+struct _AmpNodeHandle {
+	AnjutaProjectNode *node;	/* NULL if the handle is free */
+	guint32 generation;
+	guint next_free;			/* Index + 1 of next free handle or 0 */
+};
+
+static guint64
+amp_project_get_node_handle (AmpProject *project, AnjutaProjectNode *node)
 {
-	switch (AMP_NODE_DATA (g_node)->type) {
-		case ANJUTA_PROJECT_GROUP:
-			//g_hash_table_remove (project->groups, g_file_get_uri (AMP_GROUP_NODE (g_node)->file));
-			amp_group_free (g_node);
-			break;
-		case ANJUTA_PROJECT_TARGET:
-			amp_target_free (g_node);
-			break;
-		case ANJUTA_PROJECT_SOURCE:
-			//g_hash_table_remove (project->sources, AMP_NODE (g_node)->id);
-			amp_source_free (g_node);
-			break;
-		default:
-			g_assert_not_reached ();
-			break;
+	AmpNodeHandle *entry;
+	gpointer value;
+	guint index;
+
+	if (g_hash_table_lookup_extended (project->node_handles, node, NULL, &value))
+	{
+		index = GPOINTER_TO_UINT (value);
+		entry = &g_array_index (project->handles, AmpNodeHandle, index);
 	}
-}
+	else
+	{
+		if (project->free_handle != 0)
+		{
+			index = project->free_handle - 1;
+			entry = &g_array_index (project->handles, AmpNodeHandle, index);
+			project->free_handle = entry->next_free;
+		}
+		else
+		{
+			AmpNodeHandle empty = {NULL, 0, 0};
+
+			index = project->handles->len;
+			if (index == G_MAXUINT32) return 0;
+			g_array_append_val (project->handles, empty);
+			entry = &g_array_index (project->handles, AmpNodeHandle, index);
+		}
+
+		/* Generation 0 is never used, so 0 is not a valid handle */
+		entry->generation++;
+		entry->node = node;
+		entry->next_free = 0;
+		g_hash_table_insert (project->node_handles, node, GUINT_TO_POINTER (index));
+	}
+
+	return ((guint64)entry->generation << AMP_HANDLE_INDEX_BITS) | index;
+}
+
+static void
+amp_project_release_node_handle (AnjutaProjectNode *node, gpointer data)
+{
+	AmpProject *project = (AmpProject *)data;
+	gpointer value;
+
+	if (project->node_handles == NULL) return;
+	if (g_hash_table_lookup_extended (project->node_handles, node, NULL, &value))
+	{
+		guint index = GPOINTER_TO_UINT (value);
+		AmpNodeHandle *entry = &g_array_index (project->handles, AmpNodeHandle, index);
+
+		entry->node = NULL;
+		if (entry->generation != G_MAXUINT32)
+		{
+			entry->next_free = project->free_handle;
+			project->free_handle = index + 1;
+		}
+		g_hash_table_remove (project->node_handles, node);
+	}
+}
+
+/* Return the node corresponding to id or NULL if the handle is not valid
+ * anymore */
+static AnjutaProjectNode *
+amp_project_lookup_node_handle (AmpProject *project, const gchar *id, AnjutaProjectNodeType type)
+{
+	AmpNodeHandle *entry;
+	gchar *end;
+	guint64 handle;
+	guint index;
+
+	if (id == NULL) return NULL;
+	handle = g_ascii_strtoull (id, &end, 10);
+	if ((end == id) || (*end != '\0')) return NULL;
+
+	index = handle & AMP_HANDLE_INDEX_MASK;
+	if (index >= project->handles->len) return NULL;
+	entry = &g_array_index (project->handles, AmpNodeHandle, index);
+	if ((entry->node == NULL) || (entry->generation != (handle >> AMP_HANDLE_INDEX_BITS))) return NULL;
+	if (AMP_NODE_DATA (entry->node)->type != type) return NULL;
+
+	return entry->node;
+}
+
+static gchar *
+amp_project_get_node_handle_id (AmpProject *project, AnjutaProjectNode *node)
+{
+	guint64 handle = amp_project_get_node_handle (project, node);
+
+	return handle != 0 ? g_strdup_printf ("%" G_GUINT64_FORMAT, handle) : NULL;
+}
+
+static void
+foreach_node_destroy (AnjutaProjectNode    *g_node,
+		      gpointer  data)
+{
+	amp_project_release_node_handle (g_node, data);
+
+	switch (AMP_NODE_DATA (g_node)->type) {
+		case ANJUTA_PROJECT_GROUP:
+			//g_hash_table_remove (project->groups, g_file_get_uri (AMP_GROUP_NODE (g_node)->file));
+			amp_group_free (g_node);
+			break;
+		case ANJUTA_PROJECT_TARGET:
+			amp_target_free (g_node);
+			break;
+		case ANJUTA_PROJECT_SOURCE:
+			//g_hash_table_remove (project->sources, AMP_NODE (g_node)->id);
+			amp_source_free (g_node);
+			break;
+		default:
+			g_assert_not_reached ();
+			break;
+	}
+}
 
 static void
 project_node_destroy (AmpProject *project, AnjutaProjectNode *g_node)
@@ -1053,7 +1678,7 @@ amp_project_load_module (AmpProject *project, AnjutaToken *module)
 		value = anjuta_token_evaluate (arg);
 		mod = amp_module_new (arg);
 		mod->packages = NULL;
-		g_hash_table_insert (project->modules, value, mod);
+		g_hash_table_insert (project->modules, (gpointer)anjuta_string_pool_intern_take (project->strings, value), mod);
 
 		/* Package list */
 		arg = anjuta_token_next_word (arg);
@@ -1096,9 +1721,8 @@ amp_project_load_module (AmpProject *project, AnjutaToken *module)
 			}
 			else
 			{
-				pack = amp_package_new (value);
+				pack = amp_package_new (anjuta_string_pool_intern_take (project->strings, value));
 				mod->packages = g_list_prepend (mod->packages, pack);
-				g_free (value);
 				compare = NULL;
 			}
 		}
@@ -1143,40 +1767,78 @@ amp_project_load_config (AmpProject *project, AnjutaToken *arg_list)
 	}
 }
 
+/* Targets of a group are indexed by name and canonical name. The index is
+ * built when needed, then kept up to date when targets are added. It is
+ * discarded when targets are removed or replaced. */
+
 static void
-find_target (AnjutaProjectTarget *node, gpointer data)
+amp_group_index_target (AnjutaProjectGroup *group, AnjutaProjectTarget *target)
 {
-	if (AMP_NODE_DATA (node)->type == ANJUTA_PROJECT_TARGET)
-	{
-		if (strcmp (AMP_TARGET_DATA (node)->base.name, *(gchar **)data) == 0)
-		{
-			/* Find target, return node value in pointer */
-			*(AnjutaProjectTarget **)data = node;
+	AmpGroupData *data = AMP_GROUP_DATA (group);
+	const gchar *name = AMP_TARGET_DATA (target)->base.name;
+	gchar *canon_name;
 
-			return;
-		}
+	if (data->targets == NULL) return;
+
+	/* Keep the first target if several have the same name */
+	if (g_hash_table_lookup (data->targets, name) == NULL)
+	{
+		g_hash_table_insert (data->targets, g_strdup (name), target);
+	}
+	canon_name = canonicalize_automake_variable ((gchar *)name);
+	if (g_hash_table_lookup (data->canonical_targets, canon_name) == NULL)
+	{
+		g_hash_table_insert (data->canonical_targets, canon_name, target);
+	}
+	else
+	{
+		g_free (canon_name);
 	}
 }
 
 static void
-find_canonical_target (AnjutaProjectTarget *node, gpointer data)
+amp_group_clear_target_index (AnjutaProjectGroup *group)
 {
-	if (AMP_NODE_DATA (node)->type == ANJUTA_PROJECT_TARGET)
-	{
-		gchar *canon_name = canonicalize_automake_variable (AMP_TARGET_DATA (node)->base.name);	
-		DEBUG_PRINT ("compare canon %s vs %s node %p", canon_name, *(gchar **)data, node);
-		if (strcmp (canon_name, *(gchar **)data) == 0)
-		{
-			/* Find target, return node value in pointer */
-			*(AnjutaProjectTarget **)data = node;
-			g_free (canon_name);
+	AmpGroupData *data = AMP_GROUP_DATA (group);
 
-			return;
-		}
-		g_free (canon_name);
+	if (data->targets != NULL) g_hash_table_destroy (data->targets);
+	data->targets = NULL;
+	if (data->canonical_targets != NULL) g_hash_table_destroy (data->canonical_targets);
+	data->canonical_targets = NULL;
+}
+
+static void
+amp_group_build_target_index (AnjutaProjectGroup *group)
+{
+	AmpGroupData *data = AMP_GROUP_DATA (group);
+	AnjutaProjectNode *node;
+
+	if (data->targets != NULL) return;
+
+	data->targets = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	data->canonical_targets = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	for (node = anjuta_project_node_first_child (group); node != NULL; node = anjuta_project_node_next_sibling (node))
+	{
+		if (AMP_NODE_DATA (node)->type == ANJUTA_PROJECT_TARGET) amp_group_index_target (group, node);
 	}
 }
 
+static AnjutaProjectTarget *
+amp_group_find_target (AnjutaProjectGroup *group, const gchar *name)
+{
+	amp_group_build_target_index (group);
+
+	return (AnjutaProjectTarget *)g_hash_table_lookup (AMP_GROUP_DATA (group)->targets, name);
+}
+
+static AnjutaProjectTarget *
+amp_group_find_canonical_target (AnjutaProjectGroup *group, const gchar *canon_name)
+{
+	amp_group_build_target_index (group);
+
+	return (AnjutaProjectTarget *)g_hash_table_lookup (AMP_GROUP_DATA (group)->canonical_targets, canon_name);
+}
+
 static AnjutaToken*
 project_load_target (AmpProject *project, AnjutaToken *name, AnjutaTokenType token_type, AnjutaToken *list, AnjutaProjectGroup *parent, GHashTable *orphan_properties)
 {
@@ -1210,15 +1872,12 @@ project_load_target (AmpProject *project, AnjutaToken *name, AnjutaTokenType tok
 		AmpTarget *target;
 		AmpTargetPropertyBuffer *buffer;
 		gchar *orig_key;
-		gpointer find;
 
 		value = anjuta_token_evaluate (arg);
 		canon_id = canonicalize_automake_variable (value);		
 		
 		/* Check if target already exists */
-		find = value;
-		anjuta_project_node_children_foreach (parent, find_target, &find);
-		if ((gchar *)find != value)
+		if (amp_group_find_target (parent, value) != NULL)
 		{
 			/* Find target */
 			g_free (canon_id);
@@ -1227,9 +1886,10 @@ project_load_target (AmpProject *project, AnjutaToken *name, AnjutaTokenType tok
 		}
 
 		/* Create target */
-		target = amp_target_new (value, type, install, flags);
+		target = amp_target_new (project, value, type, install, flags);
 		amp_target_add_token (target, arg);
 		anjuta_project_node_append (parent, target);
+		amp_group_index_target (parent, target);
 		DEBUG_PRINT ("create target %p name %s", target, value);
 
 		/* Check if there are sources or properties availables */
@@ -1294,8 +1954,6 @@ static AnjutaToken*
 project_load_sources (AmpProject *project, AnjutaToken *name, AnjutaToken *list, AnjutaProjectGroup *parent, GHashTable *orphan_properties)
 {
 	AnjutaToken *arg;
-	AmpGroupData *group = AMP_GROUP_DATA (parent);
-	GFile *parent_file = g_object_ref (group->base.directory);
 	gchar *target_id = NULL;
 	AmpTargetPropertyBuffer *orphan = NULL;
 
@@ -1311,12 +1969,8 @@ project_load_sources (AmpProject *project, AnjutaToken *name, AnjutaToken *list,
 
 	if (target_id)
 	{
-		gpointer find;
-		
-		find = target_id;
 		DEBUG_PRINT ("search for canonical %s", target_id);
-		anjuta_project_node_children_foreach (parent, find_canonical_target, &find);
-		parent = (gchar *)find != target_id ? (AnjutaProjectTarget *)find : NULL;
+		parent = amp_group_find_canonical_target (parent, target_id);
 
 		/* Get orphan buffer if there is no target */
 		if (parent == NULL)
@@ -1337,14 +1991,11 @@ project_load_sources (AmpProject *project, AnjutaToken *name, AnjutaToken *list,
 		{
 			gchar *value;
 			AmpSource *source;
-			GFile *src_file;
 		
 			value = anjuta_token_evaluate (arg);
 
 			/* Create source */
-			src_file = g_file_get_child (parent_file, value);
-			source = amp_source_new (src_file);
-			g_object_unref (src_file);
+			source = amp_source_new (project, anjuta_string_pool_intern (project->strings, value), NULL);
 			AMP_SOURCE_DATA(source)->token = arg;
 
 			if (orphan != NULL)
@@ -1371,8 +2022,6 @@ project_load_sources (AmpProject *project, AnjutaToken *name, AnjutaToken *list,
 		}
 	}
 
-	g_object_unref (parent_file);
-
 	return NULL;
 }
 
@@ -1383,7 +2032,6 @@ project_load_data (AmpProject *project, AnjutaToken *name, AnjutaToken *list, An
 	gchar *install;
 	AnjutaProjectTarget *target;
 	gchar *target_id;
-	gpointer find;
 	gint flags;
 	AmpTargetInformation *targets = AmpTargetTypes; 
 	AnjutaToken *arg;
@@ -1413,38 +2061,29 @@ project_load_data (AmpProject *project, AnjutaToken *name, AnjutaToken *list, An
 	amp_group_add_token (parent, name, AM_GROUP_TARGET);
 
 	/* Check if target already exists */
-	find = target_id;
-	anjuta_project_node_children_foreach (parent, find_target, &find);
-	if ((gchar *)find == target_id)
+	target = amp_group_find_target (parent, target_id);
+	if (target == NULL)
 	{
 		/* Create target */
-		target = amp_target_new (target_id, type, install, flags);
+		target = amp_target_new (project, target_id, type, install, flags);
 		amp_target_add_token (target, arg);
 		anjuta_project_node_append (parent, target);
+		amp_group_index_target (parent, target);
 		DEBUG_PRINT ("create target %p name %s", target, target_id);
 	}
-	else
-	{
-		target = (AnjutaProjectTarget *)find;
-	}
 	g_free (target_id);
 
 	if (target)
 	{
-		GFile *parent_file = g_object_ref (AMP_GROUP_DATA (parent)->base.directory);
-		
 		for (arg = anjuta_token_first_word (list); arg != NULL; arg = anjuta_token_next_word (arg))
 		{
 			gchar *value;
 			AmpSource *source;
-			GFile *src_file;
 		
 			value = anjuta_token_evaluate (arg);
 
 			/* Create source */
-			src_file = g_file_get_child (parent_file, value);
-			source = amp_source_new (src_file);
-			g_object_unref (src_file);
+			source = amp_source_new (project, anjuta_string_pool_intern (project->strings, value), NULL);
 			AMP_SOURCE_DATA(source)->token = arg;
 
 			/* Add as target child */
@@ -1453,7 +2092,6 @@ project_load_data (AmpProject *project, AnjutaToken *name, AnjutaToken *list, An
 
 			g_free (value);
 		}
-		g_object_unref (parent_file);
 	}
 
 	return NULL;
@@ -1477,15 +2115,12 @@ project_load_target_properties (AmpProject *project, AnjutaToken *name, AnjutaTo
 
 	if (target_id)
 	{
-		gpointer find;
 		gchar *value;
 		AnjutaProjectPropertyInfo *prop;
 		AmpTargetPropertyBuffer *orphan = NULL;
 		
-		find = target_id;
 		DEBUG_PRINT ("search for canonical %s", target_id);
-		anjuta_project_node_children_foreach (parent, find_canonical_target, &find);
-		parent = (gchar *)find != target_id ? (AnjutaProjectTarget *)find : NULL;
+		parent = amp_group_find_canonical_target (parent, target_id);
 
 		/* Get orphan buffer if there is no target */
 		if (parent == NULL)
@@ -1531,147 +2166,607 @@ project_load_target_properties (AmpProject *project, AnjutaToken *name, AnjutaTo
 		g_free (value);
 	}
 
-	return NULL;
+	return NULL;
+}
+
+static AnjutaToken*
+project_load_group_properties (AmpProject *project, AnjutaToken *token, AnjutaTokenType type, AnjutaToken *list, AnjutaProjectGroup *parent)
+{
+	AmpGroupData *group = AMP_GROUP_DATA (parent);
+	gchar *value;
+	gchar *name;
+	AnjutaProjectPropertyInfo *prop;
+		
+	/* Create property */
+	name = anjuta_token_evaluate (token);
+	value = anjuta_token_evaluate (list);
+
+	g_message ("group_name %s", name);
+	prop = amp_property_new (name, type, 0, value, list);
+
+	amp_node_property_add (parent, prop);
+	g_free (value);
+	g_free (name);
+
+	return NULL;
+}
+
+static AmpGroup* project_load_makefile (AmpProject *project, GFile *file, AmpGroup *parent, gboolean dist_only);
+
+static void
+project_load_subdirs (AmpProject *project, AnjutaToken *list, AmpGroup *parent, gboolean dist_only)
+{
+	AnjutaToken *arg;
+
+	/* Start reading all new sub directories makefiles */
+	for (arg = anjuta_token_first_word (list); arg != NULL; arg = anjuta_token_next_word (arg))
+	{
+		gchar *value;
+		
+		value = anjuta_token_evaluate (arg);
+		if (strcmp (value, ".") != 0)
+		{
+			GFile *subdir;
+			gchar *group_id;
+
+			subdir = g_file_resolve_relative_path (AMP_GROUP_DATA (parent)->base.directory, value);
+			group_id = g_file_get_uri (subdir);
+			if (g_hash_table_lookup (project->groups, group_id) == NULL)
+			{
+				amp_project_queue_prefetch (project, subdir);
+			}
+			g_free (group_id);
+			g_object_unref (subdir);
+		}
+		g_free (value);
+	}
+
+	for (arg = anjuta_token_first_word (list); arg != NULL; arg = anjuta_token_next_word (arg))
+	{
+		gchar *value;
+		
+		value = anjuta_token_evaluate (arg);
+		
+		/* Skip ., it is a special case, used to defined build order */
+		if (strcmp (value, ".") != 0)
+		{
+			GFile *subdir;
+			gchar *group_id;
+			AmpGroup *group;
+
+			subdir = g_file_resolve_relative_path (AMP_GROUP_DATA (parent)->base.directory, value);
+			
+			/* Look for already existing group */
+			group_id = g_file_get_uri (subdir);
+			group = g_hash_table_lookup (project->groups, group_id);
+			g_free (group_id);
+
+			if (group != NULL)
+			{
+				/* Already existing group, mark for built if needed */
+				if (!dist_only) amp_group_set_dist_only (group, FALSE);
+			}
+			else
+			{
+				/* Create new group */
+				group = project_load_makefile (project, subdir, parent, dist_only);
+			}
+			amp_group_add_token (group, arg, dist_only ? AM_GROUP_TOKEN_DIST_SUBDIRS : AM_GROUP_TOKEN_SUBDIRS);
+			g_object_unref (subdir);
+		}
+		g_free (value);
+	}
+}
+
+static void
+remove_config_file (gpointer data, GObject *object, gboolean is_last_ref)
+{
+	if (is_last_ref)
+	{
+		AmpProject *project = (AmpProject *)data;
+		g_hash_table_remove (project->files, anjuta_token_file_get_file (ANJUTA_TOKEN_FILE (object)));
+	}
+}
+
+static AmpGroup*
+project_load_makefile (AmpProject *project, GFile *file, AnjutaProjectGroup *parent, gboolean dist_only)
+{
+	const gchar **filename;
+	AmpGroup *group;
+	AnjutaTokenFile *tfile;
+	GFile *makefile = NULL;
+	AmpPrefetch *prefetch;
+	gchar *content = NULL;
+	gsize length = 0;
+
+	/* Create group */
+	group = amp_group_new (project, file, dist_only);
+	g_hash_table_insert (project->groups, (gpointer)anjuta_string_pool_intern_take (project->strings, g_file_get_uri (file)), group);
+	if (parent == NULL)
+	{
+		project->root_node = group;
+	}
+	else
+	{
+		anjuta_project_node_append (parent, group);
+	}
+	
+	/* Find makefile name
+	 * It has to be in the config_files list with .am extension */
+	prefetch = amp_project_wait_prefetch (project, file);
+	for (filename = valid_am_makefiles; *filename != NULL; filename++)
+	{
+		GFileType type;
+		
+		makefile = g_file_get_child (file, *filename);
+		type = prefetch != NULL ? prefetch->type[filename - valid_am_makefiles] : file_type (file, *filename);
+		if (type == G_FILE_TYPE_REGULAR)
+		{
+			gchar *final_filename = g_strdup (*filename);
+			gchar *ptr;
+			GFile *final_file;
+			AmpConfigFile *config;
+
+			ptr = g_strrstr (final_filename,".am");
+			if (ptr != NULL) *ptr = '\0';
+			final_file = g_file_get_child (file, final_filename);
+			g_free (final_filename);
+			
+			config = g_hash_table_lookup (project->configs, final_file);
+			g_object_unref (final_file);
+			if (config != NULL)
+			{
+				g_message ("add group =%s= token %p group %p", *filename, config->token, anjuta_token_list (config->token));
+				amp_group_add_token (group, config->token, AM_GROUP_TOKEN_CONFIGURE);
+				if (prefetch != NULL)
+				{
+					/* Take prefetched content */
+					content = prefetch->content[filename - valid_am_makefiles];
+					length = prefetch->length[filename - valid_am_makefiles];
+					prefetch->content[filename - valid_am_makefiles] = NULL;
+				}
+				break;
+			}
+		}
+		g_object_unref (makefile);
+	}
+
+	if (prefetch != NULL) amp_prefetch_free (prefetch);
+
+	if (*filename == NULL)
+	{
+		/* Unable to find automake file */
+		return group;
+	}
+	
+	/* Parse makefile.am */	
+	DEBUG_PRINT ("Parse: %s", g_file_get_uri (makefile));
+	tfile = amp_group_set_makefile (group, makefile, content, length, project);
+	g_hash_table_insert (project->files, makefile, tfile);
+	g_object_add_toggle_ref (G_OBJECT (tfile), remove_config_file, project);
+	
+	return group;
+}
+
+/* Incremental reload
+ *---------------------------------------------------------------------------*/
+
+/* Check if two nodes represent the same target or source */
+static gboolean
+amp_node_equal (AnjutaProjectNode *old_node, AnjutaProjectNode *new_node)
+{
+	if (AMP_NODE_DATA (old_node)->type != AMP_NODE_DATA (new_node)->type) return FALSE;
+
+	switch (AMP_NODE_DATA (old_node)->type)
+	{
+	case ANJUTA_PROJECT_TARGET:
+		return (AMP_TARGET_DATA (old_node)->base.type == AMP_TARGET_DATA (new_node)->base.type) &&
+			(strcmp (AMP_TARGET_DATA (old_node)->base.name, AMP_TARGET_DATA (new_node)->base.name) == 0);
+	case ANJUTA_PROJECT_SOURCE:
+		if ((AMP_SOURCE_DATA (old_node)->base.name != NULL) && (AMP_SOURCE_DATA (new_node)->base.name != NULL))
+		{
+			/* Both nodes are in the same group, compare interned names */
+			return AMP_SOURCE_DATA (old_node)->base.name == AMP_SOURCE_DATA (new_node)->base.name;
+		}
+		else
+		{
+			GFile *old_file = anjuta_project_source_get_file (old_node);
+			GFile *new_file = anjuta_project_source_get_file (new_node);
+
+			return (old_file != NULL) && (new_file != NULL) && g_file_equal (old_file, new_file);
+		}
+	default:
+		return FALSE;
+	}
+}
+
+/* Compare the properties set on two nodes, they are at the beginning of
+ * the list, before the default properties */
+static gboolean
+amp_node_property_equal (AnjutaProjectNode *old_node, AnjutaProjectNode *new_node)
+{
+	GList *old_item = AMP_NODE_DATA (old_node)->properties;
+	GList *new_item = AMP_NODE_DATA (new_node)->properties;
+
+	for (; old_item != new_item; old_item = g_list_next (old_item), new_item = g_list_next (new_item))
+	{
+		AnjutaProjectPropertyInfo *old_info;
+		AnjutaProjectPropertyInfo *new_info;
+
+		if ((old_item == NULL) || (new_item == NULL)) return FALSE;
+		old_info = (AnjutaProjectPropertyInfo *)old_item->data;
+		new_info = (AnjutaProjectPropertyInfo *)new_item->data;
+		if (old_info->override != new_info->override) return FALSE;
+		if (old_info->override == NULL) break;
+		if (g_strcmp0 (old_info->value, new_info->value) != 0) return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void amp_project_patch_node (AmpProject *project, AnjutaProjectNode *old_node, AnjutaProjectNode *new_node);
+
+/* Replace the new children of parent by the matching old ones, so nodes
+ * already known outside are kept, and free the remaining old children.
+ * Return TRUE if a child has been added or removed. */
+static gboolean
+amp_project_patch_children (AmpProject *project, AnjutaProjectNode *parent, GList *old_children)
+{
+	AnjutaProjectNode *node;
+	AnjutaProjectNode *next;
+	GList *item;
+	gboolean changed = FALSE;
+
+	for (node = anjuta_project_node_first_child (parent); node != NULL; node = next)
+	{
+		next = anjuta_project_node_next_sibling (node);
+		if (AMP_NODE_DATA (node)->type == ANJUTA_PROJECT_GROUP) continue;
+
+		for (item = old_children; item != NULL; item = g_list_next (item))
+		{
+			if (amp_node_equal ((AnjutaProjectNode *)item->data, node)) break;
+		}
+		if (item == NULL)
+		{
+			g_signal_emit_by_name (G_OBJECT (project), "node-added", node);
+			changed = TRUE;
+		}
+		else
+		{
+			AnjutaProjectNode *old_node = (AnjutaProjectNode *)item->data;
+
+			old_children = g_list_delete_link (old_children, item);
+			amp_project_patch_node (project, old_node, node);
+		}
+	}
+
+	for (item = old_children; item != NULL; item = g_list_next (item))
+	{
+		g_signal_emit_by_name (G_OBJECT (project), "node-removed", item->data);
+		project_node_destroy (project, (AnjutaProjectNode *)item->data);
+		changed = TRUE;
+	}
+	g_list_free (old_children);
+
+	return changed;
+}
+
+/* Put back old_node, not in the tree, at the position of new_node with the
+ * new data and children, then free new_node */
+static void
+amp_project_patch_node (AmpProject *project, AnjutaProjectNode *old_node, AnjutaProjectNode *new_node)
+{
+	AnjutaProjectNode *child;
+	GList *old_children = NULL;
+	gpointer data;
+	gboolean changed;
+
+	anjuta_project_node_insert_before (anjuta_project_node_parent (new_node), new_node, old_node);
+	data = old_node->data;
+	old_node->data = new_node->data;
+	new_node->data = data;
+	changed = !amp_node_property_equal (new_node, old_node);
+
+	while ((child = anjuta_project_node_first_child (old_node)) != NULL)
+	{
+		anjuta_project_node_remove (child);
+		old_children = g_list_prepend (old_children, child);
+	}
+	old_children = g_list_reverse (old_children);
+	while ((child = anjuta_project_node_first_child (new_node)) != NULL)
+	{
+		anjuta_project_node_remove (child);
+		anjuta_project_node_append (old_node, child);
+	}
+	if (amp_project_patch_children (project, old_node, old_children)) changed = TRUE;
+
+	project_node_destroy (project, new_node);
+	if (changed) g_signal_emit_by_name (G_OBJECT (project), "node-changed", old_node);
+}
+
+static void
+amp_project_add_group_node (AnjutaProjectNode *node, gpointer data)
+{
+	if (AMP_NODE_DATA (node)->type == ANJUTA_PROJECT_GROUP)
+	{
+		monitor_add ((AmpProject *)data, AMP_GROUP_DATA (node)->base.directory);
+	}
+}
+
+static void
+amp_project_remove_group_node (AnjutaProjectNode *node, gpointer data)
+{
+	AmpProject *project = (AmpProject *)data;
+
+	if (AMP_NODE_DATA (node)->type == ANJUTA_PROJECT_GROUP)
+	{
+		gchar *uri;
+
+		uri = g_file_get_uri (AMP_GROUP_DATA (node)->base.directory);
+		g_hash_table_remove (project->groups, uri);
+		g_free (uri);
+		g_hash_table_remove (project->monitors, AMP_GROUP_DATA (node)->base.directory);
+	}
+}
+
+/* Forget the tokens of a node, they are going to be freed with their file
+ * while the node is still used */
+static void
+amp_project_detach_node_tokens (AnjutaProjectNode *node, gpointer data)
+{
+	GList *item;
+
+	switch (AMP_NODE_DATA (node)->type)
+	{
+	case ANJUTA_PROJECT_TARGET:
+		g_list_free (AMP_TARGET_DATA (node)->tokens);
+		AMP_TARGET_DATA (node)->tokens = NULL;
+		break;
+	case ANJUTA_PROJECT_SOURCE:
+		AMP_SOURCE_DATA (node)->token = NULL;
+		break;
+	default:
+		return;
+	}
+
+	/* Properties set in the makefile are before the default ones */
+	for (item = AMP_NODE_DATA (node)->properties; item != NULL; item = g_list_next (item))
+	{
+		AnjutaProjectPropertyInfo *info = (AnjutaProjectPropertyInfo *)item->data;
+
+		if (info->override == NULL) break;
+		((AmpPropertyInfo *)info)->token = NULL;
+	}
 }
 
-static AnjutaToken*
-project_load_group_properties (AmpProject *project, AnjutaToken *token, AnjutaTokenType type, AnjutaToken *list, AnjutaProjectGroup *parent)
+/* Read file and return its content if it is different from the one used to
+ * get the tokens. Content is NULL if the file cannot be read. */
+static gboolean
+amp_project_read_changed_file (AnjutaTokenFile *tfile, gchar **content, gsize *length)
 {
-	AmpGroupData *group = AMP_GROUP_DATA (parent);
-	gchar *value;
-	gchar *name;
-	AnjutaProjectPropertyInfo *prop;
-		
-	/* Create property */
-	name = anjuta_token_evaluate (token);
-	value = anjuta_token_evaluate (list);
+	if (!g_file_load_contents (anjuta_token_file_get_file (tfile), NULL, content, length, NULL, NULL))
+	{
+		*content = NULL;
+		*length = 0;
 
-	g_message ("group_name %s", name);
-	prop = amp_property_new (name, type, 0, value, list);
+		return TRUE;
+	}
+	if (anjuta_token_file_is_same_content (tfile, *content, *length))
+	{
+		/* Rewritten with the same content, keep current tokens */
+		g_free (*content);
+		*content = NULL;
 
-	amp_node_property_add (parent, prop);
-	g_free (value);
-	g_free (name);
+		return FALSE;
+	}
 
-	return NULL;
+	return TRUE;
 }
 
-static AmpGroup* project_load_makefile (AmpProject *project, GFile *file, AmpGroup *parent, gboolean dist_only);
-
-static void
-project_load_subdirs (AmpProject *project, AnjutaToken *list, AmpGroup *parent, gboolean dist_only)
+/* Parse again the makefile of group and update only the nodes which have
+ * changed. Return FALSE if the makefile has not changed. */
+static gboolean
+amp_project_reload_group (AmpProject *project, AmpGroup *group)
 {
-	AnjutaToken *arg;
+	AmpGroupData *data = AMP_GROUP_DATA (group);
+	AnjutaProjectNode *node;
+	AnjutaProjectNode *next;
+	AnjutaTokenFile *tfile;
+	GFile *makefile;
+	GList *old_children = NULL;
+	GList *old_groups = NULL;
+	GList *item;
+	gchar *content;
+	gsize length;
 
-	for (arg = anjuta_token_first_word (list); arg != NULL; arg = anjuta_token_next_word (arg))
+	if (!amp_project_read_changed_file (data->tfile, &content, &length)) return FALSE;
+
+	/* Remove targets and all tokens of the makefile, they are freed with it */
+	for (node = anjuta_project_node_first_child (group); node != NULL; node = next)
 	{
-		gchar *value;
-		
-		value = anjuta_token_evaluate (arg);
-		
-		/* Skip ., it is a special case, used to defined build order */
-		if (strcmp (value, ".") != 0)
+		next = anjuta_project_node_next_sibling (node);
+		if (AMP_NODE_DATA (node)->type == ANJUTA_PROJECT_GROUP)
 		{
-			GFile *subdir;
-			gchar *group_id;
-			AmpGroup *group;
+			AmpGroupData *child = AMP_GROUP_DATA (node);
+
+			g_list_free (child->tokens[AM_GROUP_TOKEN_SUBDIRS]);
+			child->tokens[AM_GROUP_TOKEN_SUBDIRS] = NULL;
+			g_list_free (child->tokens[AM_GROUP_TOKEN_DIST_SUBDIRS]);
+			child->tokens[AM_GROUP_TOKEN_DIST_SUBDIRS] = NULL;
+			child->dist_only = TRUE;
+			old_groups = g_list_prepend (old_groups, node);
+		}
+		else
+		{
+			anjuta_project_node_remove (node);
+			old_children = g_list_prepend (old_children, node);
+		}
+	}
+	old_children = g_list_reverse (old_children);
+	amp_group_clear_target_index (group);
+	g_list_free (data->tokens[AM_GROUP_TARGET]);
+	data->tokens[AM_GROUP_TARGET] = NULL;
+	anjuta_project_property_foreach (data->base.node.properties, (GFunc)amp_property_free, NULL);
+	data->base.node.properties = amp_get_group_property_list ();
 
-			subdir = g_file_resolve_relative_path (AMP_GROUP_DATA (parent)->base.directory, value);
-			
-			/* Look for already existing group */
-			group_id = g_file_get_uri (subdir);
-			group = g_hash_table_lookup (project->groups, group_id);
-			g_free (group_id);
+	/* New sub directories could have been created */
+	anjuta_directory_cache_invalidate (data->base.directory);
 
-			if (group != NULL)
-			{
-				/* Already existing group, mark for built if needed */
-				if (!dist_only) amp_group_set_dist_only (group, FALSE);
-			}
-			else
-			{
-				/* Create new group */
-				group = project_load_makefile (project, subdir, parent, dist_only);
-			}
-			amp_group_add_token (group, arg, dist_only ? AM_GROUP_TOKEN_DIST_SUBDIRS : AM_GROUP_TOKEN_SUBDIRS);
-			g_object_unref (subdir);
+	if (!amp_group_update_makefile (group, content, length, project))
+	{
+		/* The old nodes are still used until they are patched or removed,
+		 * after the old file is freed */
+		for (item = old_children; item != NULL; item = g_list_next (item))
+		{
+			anjuta_project_node_all_foreach ((AnjutaProjectNode *)item->data, amp_project_detach_node_tokens, NULL);
+		}
+
+		/* The makefile is a key of files hash table, removed with the old
+		 * file */
+		makefile = g_object_ref (data->makefile);
+		tfile = amp_group_set_makefile (group, makefile, content, length, project);
+		g_hash_table_insert (project->files, makefile, tfile);
+		g_object_add_toggle_ref (G_OBJECT (tfile), remove_config_file, project);
+	}
+
+	amp_project_patch_children (project, group, old_children);
+	amp_group_clear_target_index (group);
+
+	/* Check sub directories */
+	for (node = anjuta_project_node_first_child (group); node != NULL; node = next)
+	{
+		next = anjuta_project_node_next_sibling (node);
+		if (AMP_NODE_DATA (node)->type != ANJUTA_PROJECT_GROUP) continue;
+
+		if (g_list_find (old_groups, node) == NULL)
+		{
+			anjuta_project_node_all_foreach (node, amp_project_add_group_node, project);
+			g_signal_emit_by_name (G_OBJECT (project), "node-added", node);
+		}
+		else if ((AMP_GROUP_DATA (node)->tokens[AM_GROUP_TOKEN_SUBDIRS] == NULL) &&
+		         (AMP_GROUP_DATA (node)->tokens[AM_GROUP_TOKEN_DIST_SUBDIRS] == NULL))
+		{
+			g_signal_emit_by_name (G_OBJECT (project), "node-removed", node);
+			anjuta_project_node_all_foreach (node, amp_project_remove_group_node, project);
+			project_node_destroy (project, node);
 		}
-		g_free (value);
 	}
+	g_list_free (old_groups);
+
+	g_signal_emit_by_name (G_OBJECT (project), "node-changed", group);
+
+	return TRUE;
 }
 
-static void
-remove_config_file (gpointer data, GObject *object, gboolean is_last_ref)
+/* Find what has to be updated after a change of file. Return the directory
+ * of the group to read again if file is a makefile, set all to TRUE if the
+ * whole project has to be reloaded and return NULL for files not used by the
+ * project. */
+static gchar *
+amp_project_get_changed_group (AmpProject *project, GFile *file, gboolean deleted, gboolean *all)
 {
-	if (is_last_ref)
+	GFile *directory;
+	AmpGroup *group = NULL;
+	gchar *uri = NULL;
+
+	/* Look for a group makefile */
+	directory = g_file_get_parent (file);
+	if (directory != NULL)
 	{
-		AmpProject *project = (AmpProject *)data;
-		g_hash_table_remove (project->files, anjuta_token_file_get_file (ANJUTA_TOKEN_FILE (object)));
+		uri = g_file_get_uri (directory);
+		group = g_hash_table_lookup (project->groups, uri);
+		g_object_unref (directory);
+	}
+	if ((group != NULL) && (AMP_GROUP_DATA (group)->makefile != NULL) && g_file_equal (AMP_GROUP_DATA (group)->makefile, file))
+	{
+		if (!deleted) return uri;
+		*all = TRUE;
+	}
+	else
+	{
+		AnjutaTokenFile *tfile;
+
+		/* Look for a group directory */
+		g_free (uri);
+		uri = g_file_get_uri (file);
+		if (g_hash_table_lookup (project->groups, uri) != NULL) *all = TRUE;
+
+		/* Look for configure file */
+		tfile = g_hash_table_lookup (project->files, file);
+		if ((tfile != NULL) && !*all)
+		{
+			gchar *content = NULL;
+			gsize length;
+
+			if (deleted || amp_project_read_changed_file (tfile, &content, &length)) *all = TRUE;
+			g_free (content);
+		}
 	}
+	g_free (uri);
+
+	return NULL;
 }
 
-static AmpGroup*
-project_load_makefile (AmpProject *project, GFile *file, AnjutaProjectGroup *parent, gboolean dist_only)
+/* Update the project once no monitor event has been received during the
+ * monitor delay. Each changed makefile is read only once and the whole
+ * project is reloaded at most once. */
+static gboolean
+amp_project_refresh_dirty (gpointer data)
 {
-	const gchar **filename;
-	AmpGroup *group;
-	AnjutaTokenFile *tfile;
-	GFile *makefile = NULL;
+	AmpProject *project = (AmpProject *)data;
+	GHashTable *dirty;
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+	GList *groups = NULL;
+	GList *item;
+	gboolean all = FALSE;
+	gboolean changed = FALSE;
 
-	/* Create group */
-	group = amp_group_new (file, dist_only);
-	g_hash_table_insert (project->groups, g_file_get_uri (file), group);
-	if (parent == NULL)
+	/* Reloading the project clears the pending events */
+	dirty = project->dirty;
+	project->dirty = g_hash_table_new_full (g_file_hash, (GEqualFunc)g_file_equal, g_object_unref, NULL);
+	project->dirty_timeout = 0;
+
+	g_hash_table_iter_init (&iter, dirty);
+	while (g_hash_table_iter_next (&iter, &key, &value))
 	{
-		project->root_node = group;
+		gchar *uri;
+
+		uri = amp_project_get_changed_group (project, (GFile *)key, GPOINTER_TO_INT (value), &all);
+		if (uri != NULL) groups = g_list_prepend (groups, uri);
 	}
-	else
+	g_hash_table_destroy (dirty);
+
+	if (all)
 	{
-		anjuta_project_node_append (parent, group);
+		amp_project_reload (project, NULL);
+		project->monitor_reloads++;
 	}
-	
-	/* Find makefile name
-	 * It has to be in the config_files list with .am extension */
-	for (filename = valid_am_makefiles; *filename != NULL; filename++)
+	else
 	{
-		makefile = g_file_get_child (file, *filename);
-		if (file_type (file, *filename) == G_FILE_TYPE_REGULAR)
+		for (item = groups; item != NULL; item = g_list_next (item))
 		{
-			gchar *final_filename = g_strdup (*filename);
-			gchar *ptr;
-			GFile *final_file;
-			AmpConfigFile *config;
+			AmpGroup *group;
 
-			ptr = g_strrstr (final_filename,".am");
-			if (ptr != NULL) *ptr = '\0';
-			final_file = g_file_get_child (file, final_filename);
-			g_free (final_filename);
-			
-			config = g_hash_table_lookup (project->configs, final_file);
-			g_object_unref (final_file);
-			if (config != NULL)
+			/* The group could have been removed with its parent */
+			group = g_hash_table_lookup (project->groups, (gchar *)item->data);
+			if ((group != NULL) && amp_project_reload_group (project, group))
 			{
-				g_message ("add group =%s= token %p group %p", *filename, config->token, anjuta_token_list (config->token));
-				amp_group_add_token (group, config->token, AM_GROUP_TOKEN_CONFIGURE);
-				break;
+				project->monitor_reloads++;
+				changed = TRUE;
 			}
 		}
-		g_object_unref (makefile);
 	}
+	g_list_foreach (groups, (GFunc)g_free, NULL);
+	g_list_free (groups);
 
-	if (*filename == NULL)
+	if (all || changed)
 	{
-		/* Unable to find automake file */
-		return group;
+		g_signal_emit_by_name (G_OBJECT (project), "project-updated");
 	}
-	
-	/* Parse makefile.am */	
-	DEBUG_PRINT ("Parse: %s", g_file_get_uri (makefile));
-	tfile = amp_group_set_makefile (group, makefile, project);
-	g_hash_table_insert (project->files, makefile, tfile);
-	g_object_add_toggle_ref (G_OBJECT (tfile), remove_config_file, project);
-	
-	return group;
+
+	return FALSE;
 }
 
 void
@@ -1752,8 +2847,15 @@ amp_project_reload (AmpProject *project, GError **error)
 	project->root_file = root_file;
 	DEBUG_PRINT ("reload project %p root file %p", project, project->root_file);
 
+	/* Files could have been changed outside, read all project directories
+	 * again */
+	anjuta_directory_cache_invalidate_tree (root_file);
+
+	/* A new string pool for each load */
+	project->strings = anjuta_string_pool_new ();
+
 	/* shortcut hash tables */
-	project->groups = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	project->groups = g_hash_table_new (g_str_hash, g_str_equal);
 	project->files = g_hash_table_new_full (g_file_hash, (GEqualFunc)g_file_equal, g_object_unref, g_object_unref);
 	project->configs = g_hash_table_new_full (g_file_hash, (GEqualFunc)g_file_equal, NULL, (GDestroyNotify)amp_config_file_free);
 	amp_project_new_module_hash (project);
@@ -1789,6 +2891,7 @@ amp_project_reload (AmpProject *project, GError **error)
 	fprintf (stdout, "AC file before parsing\n");
 	anjuta_token_dump (arg);
 	fprintf (stdout, "\n");
+	anjuta_token_pool_push (anjuta_token_file_get_pool (project->configure_file));
 	scanner = amp_ac_scanner_new (project);
 	project->configure_token = amp_ac_scanner_parse_token (scanner, arg, 0, &err);
 	fprintf (stdout, "AC file after parsing\n");
@@ -1796,6 +2899,7 @@ amp_project_reload (AmpProject *project, GError **error)
 	anjuta_token_dump (project->configure_token);
 	fprintf (stdout, "\n");
 	amp_ac_scanner_free (scanner);
+	anjuta_token_pool_pop ();
 	if (project->configure_token == NULL)
 	{
 		g_set_error (error, IANJUTA_PROJECT_ERROR, 
@@ -1809,6 +2913,7 @@ amp_project_reload (AmpProject *project, GError **error)
 	monitors_setup (project);
 
 	/* Load all makefiles recursively */
+	amp_project_start_prefetch (project);
 	if (project_load_makefile (project, project->root_file, NULL, FALSE) == NULL)
 	{
 		g_set_error (error, IANJUTA_PROJECT_ERROR, 
@@ -1817,6 +2922,7 @@ amp_project_reload (AmpProject *project, GError **error)
 
 		ok = FALSE;
 	}
+	amp_project_stop_prefetch (project);
 	
 	return ok;
 }
@@ -1847,9 +2953,11 @@ amp_project_unload (AmpProject *project)
 	project_node_destroy (project, project->root_node);
 	project->root_node = NULL;
 
+	/* configure_token can be allocated in configure_file pool */
+	if (project->configure_token) anjuta_token_free (project->configure_token);
+	project->configure_token = NULL;
 	if (project->configure_file)	g_object_unref (G_OBJECT (project->configure_file));
 	project->configure_file = NULL;
-	if (project->configure_token) anjuta_token_free (project->configure_token);
 
 	if (project->root_file) g_object_unref (project->root_file);
 	project->root_file = NULL;
@@ -1871,6 +2979,82 @@ amp_project_unload (AmpProject *project)
 	if (project->arg_list) anjuta_token_style_free (project->arg_list);
 	
 	amp_project_free_module_hash (project);
+
+	/* Names are used by the nodes, all destroyed above */
+	anjuta_string_pool_free (project->strings);
+	project->strings = NULL;
+}
+
+/* Set the time in milliseconds without file change needed before updating
+ * the project, all changes received in between are handled at once. If files
+ * keep changing, the project is updated after AMP_MONITOR_MAX_DELAYS delays */
+void
+amp_project_set_monitor_delay (AmpProject *project, guint delay)
+{
+	g_return_if_fail (AMP_IS_PROJECT (project));
+
+	project->monitor_delay = delay;
+}
+
+/* Set the directory where snapshots of parsed makefiles are kept, NULL
+ * disables snapshots. They are disabled by default. */
+void
+amp_project_set_snapshot_directory (AmpProject *project, const gchar *directory)
+{
+	g_return_if_fail (AMP_IS_PROJECT (project));
+
+	g_free (project->snapshot_directory);
+	project->snapshot_directory = g_strdup (directory);
+}
+
+/* Get the number of distinct names kept by the project and the memory saved
+ * by sharing them */
+void
+amp_project_get_string_stats (AmpProject *project, guint *count, gsize *saved)
+{
+	g_return_if_fail (AMP_IS_PROJECT (project));
+
+	anjuta_string_pool_get_stats (project->strings, count, saved);
+}
+
+/* Walk the token trees of all makefiles, counting tokens and evaluating
+ * them. It is used to measure full tree walks */
+void
+amp_project_get_token_stats (AmpProject *project, guint *count, gsize *length)
+{
+	GHashTableIter iter;
+	AmpGroup *node;
+	guint tokens = 0;
+	gsize chars = 0;
+
+	g_return_if_fail (AMP_IS_PROJECT (project));
+
+	g_hash_table_iter_init (&iter, project->groups);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&node))
+	{
+		AnjutaToken *root = AMP_GROUP_DATA (node)->make_token;
+		AnjutaToken *token;
+		gchar *value;
+
+		if (root == NULL) continue;
+
+		for (token = root; token != NULL; token = anjuta_token_next (token)) tokens++;
+		value = anjuta_token_evaluate (root);
+		if (value != NULL) chars += strlen (value);
+		g_free (value);
+	}
+
+	if (count != NULL) *count = tokens;
+	if (length != NULL) *length = chars;
+}
+
+void
+amp_project_get_monitor_stats (AmpProject *project, guint *events, guint *reloads)
+{
+	g_return_if_fail (AMP_IS_PROJECT (project));
+
+	if (events != NULL) *events = project->monitor_events;
+	if (reloads != NULL) *reloads = project->monitor_reloads;
 }
 
 gint
@@ -1917,20 +3101,16 @@ amp_project_probe (GFile *file,
 gboolean
 amp_project_get_token_location (AmpProject *project, AnjutaTokenFileLocation *location, AnjutaToken *token)
 {
-	GHashTableIter iter;
-	gpointer key;
-	gpointer value;
+	AnjutaTokenFile *tfile;
 
-	g_hash_table_iter_init (&iter, project->files);
-	while (g_hash_table_iter_next (&iter, &key, &value))
+	/* Check that the file containing the token belongs to this project */
+	tfile = anjuta_token_file_lookup (token);
+	if ((tfile == NULL) || (g_hash_table_lookup (project->files, anjuta_token_file_get_file (tfile)) != tfile))
 	{
-		if (anjuta_token_file_get_token_location ((AnjutaTokenFile *)value, location, token))
-		{
-			return TRUE;
-		}
+		return FALSE;
 	}
 
-	return FALSE;
+	return anjuta_token_file_get_token_location (tfile, location, token);
 }
 
 AmpGroup*
@@ -1997,8 +3177,8 @@ amp_project_add_sibling_group (AmpProject  *project,
 	}
 	
 	/* Add group node in project tree */
-	child = amp_group_new (directory, FALSE);
-	g_hash_table_insert (project->groups, uri, child);
+	child = amp_group_new (project, directory, FALSE);
+	g_hash_table_insert (project->groups, (gpointer)anjuta_string_pool_intern_take (project->strings, uri), child);
 	g_object_unref (directory);
 	if (after)
 	{
@@ -2011,6 +3191,7 @@ amp_project_add_sibling_group (AmpProject  *project,
 
 	/* Create directory */
 	g_file_make_directory (directory, NULL, NULL);
+	anjuta_directory_cache_invalidate (AMP_GROUP_DATA (parent)->base.directory);
 
 	/* Create Makefile.am */
 	basename = AMP_GROUP_DATA (parent)->makefile != NULL ? g_file_get_basename (AMP_GROUP_DATA (parent)->makefile) : NULL;
@@ -2024,7 +3205,7 @@ amp_project_add_sibling_group (AmpProject  *project,
 		makefile = g_file_get_child (directory, "Makefile.am");
 	}
 	g_file_replace_contents (makefile, "", 0, NULL, FALSE, G_FILE_CREATE_NONE, NULL, NULL, NULL);
-	tfile = amp_group_set_makefile (child, makefile, project);
+	tfile = amp_group_set_makefile (child, makefile, NULL, 0, project);
 	g_hash_table_insert (project->files, makefile, tfile);
 	g_object_add_toggle_ref (G_OBJECT (tfile), remove_config_file, project);
 
@@ -2182,6 +3363,7 @@ amp_project_remove_group (AmpProject  *project,
 		anjuta_token_remove_word ((AnjutaToken *)token_list->data, NULL);
 	}
 
+	anjuta_project_node_all_foreach (group, amp_project_release_node_handle, project);
 	amp_group_free (group);
 }
 
@@ -2194,7 +3376,6 @@ amp_project_add_sibling_target (AmpProject  *project, AmpGroup *parent, const gc
 	AnjutaToken *var;
 	AnjutaToken *prev;
 	gchar *targetname;
-	gchar *find;
 	GList *last;
 	
 	g_return_val_if_fail (name != NULL, NULL);
@@ -2250,9 +3431,7 @@ amp_project_add_sibling_target (AmpProject  *project, AmpGroup *parent, const gc
 	}
 	
 	/* Check that the new target doesn't already exist */
-	find = (gchar *)name;
-	anjuta_project_node_children_foreach (parent, find_target, &find);
-	if ((gchar *)find != name)
+	if (amp_group_find_target (parent, name) != NULL)
 	{
 		error_set (error, IANJUTA_PROJECT_ERROR_DOESNT_EXIST,
 			_("Target already exists"));
@@ -2261,7 +3440,7 @@ amp_project_add_sibling_target (AmpProject  *project, AmpGroup *parent, const gc
 	}
 	
 	/* Add target node in project tree */
-	child = amp_target_new (name, type, "", 0);
+	child = amp_target_new (project, name, type, "", 0);
 	if (after)
 	{
 		anjuta_project_node_insert_after (parent, sibling, child);
@@ -2270,6 +3449,7 @@ amp_project_add_sibling_target (AmpProject  *project, AmpGroup *parent, const gc
 	{
 		anjuta_project_node_insert_before (parent, sibling, child);
 	}
+	amp_group_index_target (parent, child);
 	//anjuta_project_node_append (parent, child);
 
 	/* Add in Makefile.am */
@@ -2380,6 +3560,8 @@ amp_project_remove_target (AmpProject  *project,
 		anjuta_token_remove_word ((AnjutaToken *)token_list->data, NULL);
 	}
 
+	if (anjuta_project_node_parent (target) != NULL) amp_group_clear_target_index (anjuta_project_node_parent (target));
+	anjuta_project_node_all_foreach (target, amp_project_release_node_handle, project);
 	amp_target_free (target);
 }
 
@@ -2459,7 +3641,7 @@ amp_project_add_sibling_source (AmpProject  *project, AmpTarget *target, GFile *
 	}
 
 	/* Add source node in project tree */
-	source = amp_source_new (file);
+	source = amp_source_new (project, relative_name == NULL ? NULL : anjuta_string_pool_intern_take (project->strings, relative_name), file);
 	AMP_SOURCE_DATA(source)->token = token;
 	if (after)
 	{
@@ -2493,6 +3675,7 @@ amp_project_remove_source (AmpProject  *project,
 	
 	anjuta_token_remove_word (AMP_SOURCE_DATA (source)->token, NULL);
 
+	amp_project_release_node_handle (source, project);
 	amp_source_free (source);
 }
 
@@ -2521,7 +3704,7 @@ amp_project_get_config_packages  (AmpProject *project,
 
 		for (node = mod->packages; node != NULL; node = g_list_next (node))
 		{
-			packages = g_list_prepend (packages, ((AmpPackage *)node->data)->name);
+			packages = g_list_prepend (packages, (gpointer)((AmpPackage *)node->data)->name);
 		}
 
 		packages = g_list_reverse (packages);
@@ -2593,9 +3776,15 @@ foreach_node_move (AnjutaProjectNode *g_node, gpointer data)
 		g_object_unref (AMP_GROUP_DATA (g_node)->base.directory);
 		AMP_GROUP_DATA (g_node)->base.directory = new_file;
 
-		g_hash_table_insert (project->groups, g_file_get_uri (new_file), g_node);
+		g_hash_table_insert (project->groups, (gpointer)anjuta_string_pool_intern_take (project->strings, g_file_get_uri (new_file)), g_node);
 		break;
 	case ANJUTA_PROJECT_SOURCE:
+		if (AMP_SOURCE_DATA (g_node)->base.name != NULL)
+		{
+			/* Recreated from the group directory when needed */
+			anjuta_project_source_clear_file (g_node);
+			break;
+		}
 		relative = get_relative_path (old_root_file, AMP_SOURCE_DATA (g_node)->base.file);
 		new_file = g_file_resolve_relative_path (project->root_file, relative);
 		g_free (relative);
@@ -2625,7 +3814,7 @@ amp_project_move (AmpProject *project, const gchar *path)
 
 	/* Change project root directory in groups */
 	old_hash = project->groups;
-	project->groups = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	project->groups = g_hash_table_new (g_str_hash, g_str_equal);
 	anjuta_project_node_all_foreach (project->root_node, foreach_node_move, &packet);
 	g_hash_table_destroy (old_hash);
 
@@ -2702,29 +3891,13 @@ amp_project_get_group (AmpProject *project, const gchar *id)
 AmpTarget *
 amp_project_get_target (AmpProject *project, const gchar *id)
 {
-	AmpTarget **buffer;
-	AmpTarget *target;
-	gsize dummy;
-
-	buffer = (AmpTarget **)g_base64_decode (id, &dummy);
-	target = *buffer;
-	g_free (buffer);
-
-	return target;
+	return amp_project_lookup_node_handle (project, id, ANJUTA_PROJECT_TARGET);
 }
 
 AmpSource *
 amp_project_get_source (AmpProject *project, const gchar *id)
 {
-	AmpSource **buffer;
-	AmpSource *source;
-	gsize dummy;
-
-	buffer = (AmpSource **)g_base64_decode (id, &dummy);
-	source = *buffer;
-	g_free (buffer);
-
-	return source;
+	return amp_project_lookup_node_handle (project, id, ANJUTA_PROJECT_SOURCE);
 }
 
 gchar *
@@ -2770,12 +3943,26 @@ amp_project_get_node_id (AmpProject *project, const gchar *path)
 			return g_file_get_uri (AMP_GROUP_DATA (node)->base.directory);
 		case ANJUTA_PROJECT_TARGET:
 		case ANJUTA_PROJECT_SOURCE:
-			return g_base64_encode ((guchar *)&node, sizeof (node));
+			return amp_project_get_node_handle_id (project, node);
 		default:
 			return NULL;
 	}
 }
 
+/* Return the path of the node having this id, the inverse of
+ * amp_project_get_node_id */
+gchar *
+amp_project_get_node_path (AmpProject *project, const gchar *id)
+{
+	AnjutaProjectNode *node;
+
+	node = amp_project_get_group (project, id);
+	if (node == NULL) node = amp_project_get_target (project, id);
+	if (node == NULL) node = amp_project_get_source (project, id);
+
+	return node != NULL ? anjuta_project_node_get_path (node) : NULL;
+}
+
 gchar *
 amp_project_get_uri (AmpProject *project)
 {
@@ -2950,6 +4137,30 @@ iproject_refresh (IAnjutaProject *obj, GError **err)
 static gboolean
 iproject_remove_node (IAnjutaProject *obj, AnjutaProjectNode *node, GError **err)
 {
+	GError *error = NULL;
+
+	switch (AMP_NODE_DATA (node)->type)
+	{
+		case ANJUTA_PROJECT_GROUP:
+			amp_project_remove_group (AMP_PROJECT (obj), AMP_GROUP (node), &error);
+			break;
+		case ANJUTA_PROJECT_TARGET:
+			amp_project_remove_target (AMP_PROJECT (obj), AMP_TARGET (node), &error);
+			break;
+		case ANJUTA_PROJECT_SOURCE:
+			amp_project_remove_source (AMP_PROJECT (obj), AMP_SOURCE (node), &error);
+			break;
+		default:
+			return FALSE;
+	}
+
+	if (error != NULL)
+	{
+		g_propagate_error (err, error);
+
+		return FALSE;
+	}
+
 	return TRUE;
 }
 
@@ -3023,24 +4234,24 @@ amp_target_get_type (AmpTarget *target)
 }
 
 gchar *
-amp_target_get_id (AmpTarget *target)
+amp_target_get_id (AmpProject *project, AmpTarget *target)
 {
-	return g_base64_encode ((guchar *)&target, sizeof (target));
+	return amp_project_get_node_handle_id (project, target);
 }
 
 /* Source access functions
  *---------------------------------------------------------------------------*/
 
 gchar *
-amp_source_get_id (AmpSource *source)
+amp_source_get_id (AmpProject *project, AmpSource *source)
 {
-	return g_base64_encode ((guchar *)&source, sizeof (source));
+	return amp_project_get_node_handle_id (project, source);
 }
 
 GFile*
 amp_source_get_file (AmpSource *source)
 {
-	return AMP_SOURCE_DATA (source)->base.file;
+	return anjuta_project_source_get_file (source);
 }
 
 /* GbfProject implementation
@@ -3052,6 +4263,15 @@ amp_project_dispose (GObject *object)
 	g_return_if_fail (AMP_IS_PROJECT (object));
 
 	amp_project_unload (AMP_PROJECT (object));
+	if (AMP_PROJECT (object)->dirty != NULL) g_hash_table_destroy (AMP_PROJECT (object)->dirty);
+	AMP_PROJECT (object)->dirty = NULL;
+	if (AMP_PROJECT (object)->node_handles != NULL) g_hash_table_destroy (AMP_PROJECT (object)->node_handles);
+	AMP_PROJECT (object)->node_handles = NULL;
+	if (AMP_PROJECT (object)->handles != NULL) g_array_free (AMP_PROJECT (object)->handles, TRUE);
+	AMP_PROJECT (object)->handles = NULL;
+	g_free (AMP_PROJECT (object)->snapshot_directory);
+	anjuta_project_arena_free (AMP_PROJECT (object)->nodes);
+	AMP_PROJECT (object)->nodes = NULL;
 
 	G_OBJECT_CLASS (parent_class)->dispose (object);	
 }
@@ -3074,6 +4294,25 @@ amp_project_instance_init (AmpProject *project)
 	project->am_space_list = NULL;
 	project->ac_space_list = NULL;
 	project->arg_list = NULL;
+
+	project->prefetch_pool = NULL;
+	project->prefetch = NULL;
+	project->prefetch_lock = NULL;
+	project->prefetch_cond = NULL;
+
+	project->dirty = g_hash_table_new_full (g_file_hash, (GEqualFunc)g_file_equal, g_object_unref, NULL);
+	project->dirty_timeout = 0;
+	project->monitor_delay = AMP_MONITOR_DELAY;
+	project->monitor_events = 0;
+	project->monitor_reloads = 0;
+
+	project->strings = NULL;
+	project->snapshot_directory = NULL;
+	project->nodes = anjuta_project_arena_new ();
+
+	project->handles = g_array_new (FALSE, FALSE, sizeof (AmpNodeHandle));
+	project->node_handles = g_hash_table_new (g_direct_hash, g_direct_equal);
+	project->free_handle = 0;
 }
 
 static void
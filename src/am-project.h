@@ -83,6 +83,12 @@ gboolean amp_project_load (AmpProject *project, GFile *directory, GError **error
 gboolean amp_project_reload (AmpProject *project, GError **error);
 void amp_project_unload (AmpProject *project);
 
+void amp_project_set_monitor_delay (AmpProject *project, guint delay);
+void amp_project_set_snapshot_directory (AmpProject *project, const gchar *directory);
+void amp_project_get_monitor_stats (AmpProject *project, guint *events, guint *reloads);
+void amp_project_get_string_stats (AmpProject *project, guint *count, gsize *saved);
+void amp_project_get_token_stats (AmpProject *project, guint *count, gsize *length);
+
 void amp_project_load_config (AmpProject *project, AnjutaToken *arg_list);
 void amp_project_load_properties (AmpProject *project, AnjutaToken *macro, AnjutaToken *list);
 void amp_project_load_module (AmpProject *project, AnjutaToken *module);
@@ -123,6 +129,7 @@ AnjutaProjectPropertyList *amp_project_get_property_list (AmpProject *project);
 //gboolean amp_project_set_property (AmpProject *project, AmpPropertyType type, const gchar* value);
 
 gchar * amp_project_get_node_id (AmpProject *project, const gchar *path);
+gchar * amp_project_get_node_path (AmpProject *project, const gchar *id);
 
 AnjutaProjectNode *amp_node_parent (AnjutaProjectNode *node);
 AnjutaProjectNode *amp_node_first_child (AnjutaProjectNode *node);
@@ -138,10 +145,10 @@ gchar *amp_group_get_id (AmpGroup *group);
 
 const gchar *amp_target_get_name (AmpTarget *target);
 AnjutaProjectTargetType amp_target_get_type (AmpTarget *target);
-gchar *amp_target_get_id (AmpTarget *target);
+gchar *amp_target_get_id (AmpProject *project, AmpTarget *target);
 
 void amp_source_free (AmpSource *node);
-gchar *amp_source_get_id (AmpSource *source);
+gchar *amp_source_get_id (AmpProject *project, AmpSource *source);
 GFile *amp_source_get_file (AmpSource *source);
 
 G_END_DECLS
@@ -36,12 +36,23 @@ G_BEGIN_DECLS
 
 typedef struct _AmpAmScanner AmpAmScanner;
 
+/* Automake variable found by the parser */
+typedef struct _AmpAmVariable
+{
+	AnjutaTokenType variable;
+	AnjutaToken *name;
+	AnjutaToken *list;
+} AmpAmVariable;
+
 AmpAmScanner *amp_am_scanner_new (AmpProject *project, AmpGroup *group);
 void amp_am_scanner_free (AmpAmScanner *scanner);
 
 AnjutaToken *amp_am_scanner_parse_token (AmpAmScanner *scanner, AnjutaToken *token, GError **error);
 
 void amp_am_scanner_set_am_variable (AmpAmScanner *scanner, AnjutaTokenType variable, AnjutaToken *name, AnjutaToken *list);
+GArray *amp_am_scanner_get_variables (AmpAmScanner *scanner);
+GArray *amp_am_scanner_steal_variables (AmpAmScanner *scanner);
+void amp_am_scanner_set_record_only (AmpAmScanner *scanner, gboolean record_only);
 
 void amp_am_yyerror (YYLTYPE *loc, AmpAmScanner *scanner, char const *s);
 
@@ -0,0 +1,280 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * am-snapshot.c
+ * Copyright (C) Sébastien Granjoux 2009 <seb.sfo@free.fr>
+ * 
+ * main.c is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * main.c is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* A snapshot keeps the parsed token tree of a Makefile.am and the list of
+ * automake variables found by the parser. Snapshots are disabled by default,
+ * when a snapshot directory is set, they are written there and used instead
+ * of parsing the file again if its size, modification time and content
+ * checksum have not changed. The project nodes are still created from the
+ * variables, so loading a snapshot gives exactly the same result than
+ * parsing the file.
+ *
+ * The token tree is saved in the byte order of the machine, snapshots
+ * written with another byte order are ignored. */
+
+#include "am-snapshot.h"
+
+#include "libanjuta/anjuta-debug.h"
+
+#include <glib/gstdio.h>
+#include <string.h>
+
+/* Types
+ *---------------------------------------------------------------------------*/
+
+#define AMP_SNAPSHOT_MAGIC		0x414D5331		/* "AMS1" */
+#define AMP_SNAPSHOT_BYTE_ORDER	0x01020304
+#define AMP_SNAPSHOT_VERSION	2
+
+/* Snapshot header, followed by the token tree and the variables */
+typedef struct _AmpSnapshotHeader
+{
+	guint32 magic;
+	guint32 byte_order;		/* AMP_SNAPSHOT_BYTE_ORDER in writer order */
+	guint32 version;
+	guint32 variables;
+	guint64 size;
+	guint64 mtime;
+	gchar checksum[32];
+} AmpSnapshotHeader;
+
+/* Automake variable with token indexes, -1 for NULL */
+typedef struct _AmpSnapshotVariable
+{
+	gint32 variable;
+	gint32 name;
+	gint32 list;
+} AmpSnapshotVariable;
+
+/* Helper functions
+ *---------------------------------------------------------------------------*/
+
+static gchar *
+amp_am_snapshot_get_filename (const gchar *directory, GFile *makefile)
+{
+	gchar *uri;
+	gchar *name;
+	gchar *filename;
+
+	uri = g_file_get_uri (makefile);
+	name = g_compute_checksum_for_string (G_CHECKSUM_MD5, uri, -1);
+	filename = g_strconcat (name, ".am", NULL);
+	g_free (name);
+	g_free (uri);
+
+	name = g_build_filename (directory, filename, NULL);
+	g_free (filename);
+
+	return name;
+}
+
+static gboolean
+amp_am_snapshot_init_header (AmpSnapshotHeader *header, GFile *makefile, const gchar *content, gsize length)
+{
+	GFileInfo *info;
+	gchar *checksum;
+
+	info = g_file_query_info (makefile, G_FILE_ATTRIBUTE_TIME_MODIFIED, G_FILE_QUERY_INFO_NONE, NULL, NULL);
+	if (info == NULL) return FALSE;
+
+	memset (header, 0, sizeof (AmpSnapshotHeader));
+	header->magic = AMP_SNAPSHOT_MAGIC;
+	header->byte_order = AMP_SNAPSHOT_BYTE_ORDER;
+	header->version = AMP_SNAPSHOT_VERSION;
+	header->size = length;
+	header->mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+	g_object_unref (info);
+
+	checksum = g_compute_checksum_for_data (G_CHECKSUM_MD5, (const guchar *)content, length);
+	memcpy (header->checksum, checksum, sizeof (header->checksum));
+	g_free (checksum);
+
+	return TRUE;
+}
+
+/* Check that a saved header matches the current file, field by field */
+static gboolean
+amp_am_snapshot_check_header (const AmpSnapshotHeader *saved, const AmpSnapshotHeader *header)
+{
+	return (saved->magic == header->magic) &&
+		(saved->byte_order == header->byte_order) &&
+		(saved->version == header->version) &&
+		(saved->size == header->size) &&
+		(saved->mtime == header->mtime) &&
+		(memcmp (saved->checksum, header->checksum, sizeof (header->checksum)) == 0);
+}
+
+/* Get the content fragment of a file loaded in one memory block */
+static AnjutaToken *
+amp_am_snapshot_get_fragment (AnjutaToken *content)
+{
+	AnjutaToken *frag;
+
+	frag = anjuta_token_next (content);
+	if ((frag == NULL) || (anjuta_token_get_length (frag) == 0) || (anjuta_token_next (frag) != NULL)) return NULL;
+
+	return frag;
+}
+
+/* Public functions
+ *---------------------------------------------------------------------------*/
+
+/* Recreate the token tree of makefile from its snapshot if it is still valid
+ * and create all project nodes. Return the root token or NULL if the file
+ * has to be parsed. */
+AnjutaToken *
+amp_am_snapshot_load (AmpAmScanner *scanner, const gchar *directory, GFile *makefile, AnjutaToken *content)
+{
+	AnjutaToken *frag;
+	AnjutaToken *root;
+	AnjutaToken **tokens;
+	AmpSnapshotHeader header;
+	const AmpSnapshotHeader *saved;
+	const AmpSnapshotVariable *variables;
+	GMappedFile *mapped;
+	gchar *filename;
+	gchar *data;
+	gsize size;
+	gsize tree_size;
+	guint count;
+	guint i;
+
+	if (directory == NULL) return NULL;
+	frag = amp_am_snapshot_get_fragment (content);
+	if (frag == NULL) return NULL;
+
+	filename = amp_am_snapshot_get_filename (directory, makefile);
+	mapped = g_mapped_file_new (filename, FALSE, NULL);
+	g_free (filename);
+	if (mapped == NULL) return NULL;
+
+	data = g_mapped_file_get_contents (mapped);
+	size = g_mapped_file_get_length (mapped);
+	saved = (const AmpSnapshotHeader *)data;
+	if ((size < sizeof (AmpSnapshotHeader)) ||
+	    !amp_am_snapshot_init_header (&header, makefile, anjuta_token_get_string (frag), anjuta_token_get_length (frag)) ||
+	    !amp_am_snapshot_check_header (saved, &header))
+	{
+		g_mapped_file_free (mapped);
+		return NULL;
+	}
+
+	tree_size = size - sizeof (AmpSnapshotHeader);
+	tokens = anjuta_token_load_tree (data + sizeof (AmpSnapshotHeader), &tree_size, (gchar *)anjuta_token_get_string (frag), anjuta_token_get_length (frag), &count);
+	if (tokens == NULL)
+	{
+		g_mapped_file_free (mapped);
+		return NULL;
+	}
+	root = tokens[0];
+
+	variables = (const AmpSnapshotVariable *)(data + sizeof (AmpSnapshotHeader) + tree_size);
+	if (saved->variables > (size - sizeof (AmpSnapshotHeader) - tree_size) / sizeof (AmpSnapshotVariable))
+	{
+		i = 0;
+	}
+	else
+	{
+		for (i = 0; i < saved->variables; i++)
+		{
+			if ((variables[i].name < -1) || (variables[i].name >= (gint32)count) ||
+			    (variables[i].list < -1) || (variables[i].list >= (gint32)count)) break;
+		}
+	}
+	if (i != saved->variables)
+	{
+		/* Invalid snapshot */
+		anjuta_token_free (root);
+		root = NULL;
+	}
+	else
+	{
+#ifdef DEBUG
+		gchar *path = g_file_get_path (makefile);
+		
+		DEBUG_PRINT ("Use snapshot of %s", path);
+		g_free (path);
+#endif
+		for (i = 0; i < saved->variables; i++)
+		{
+			amp_am_scanner_set_am_variable (scanner, variables[i].variable,
+			                                variables[i].name == -1 ? NULL : tokens[variables[i].name],
+			                                variables[i].list == -1 ? NULL : tokens[variables[i].list]);
+		}
+	}
+	g_free (tokens);
+	g_mapped_file_free (mapped);
+
+	return root;
+}
+
+/* Write a snapshot of makefile after parsing it. Failures are ignored, the
+ * file is just parsed again the next time. */
+void
+amp_am_snapshot_save (AmpAmScanner *scanner, const gchar *directory, GFile *makefile, AnjutaToken *content, AnjutaToken *root)
+{
+	AnjutaToken *frag;
+	AmpSnapshotHeader header;
+	GArray *variables;
+	GHashTable *indexes;
+	GByteArray *data;
+	gchar *filename;
+	guint i;
+
+	if (directory == NULL) return;
+	frag = amp_am_snapshot_get_fragment (content);
+	if ((frag == NULL) || (root == NULL)) return;
+	if (!amp_am_snapshot_init_header (&header, makefile, anjuta_token_get_string (frag), anjuta_token_get_length (frag))) return;
+
+	indexes = g_hash_table_new (g_direct_hash, g_direct_equal);
+	data = anjuta_token_save_tree (root, anjuta_token_get_string (frag), anjuta_token_get_length (frag), indexes);
+	if (data == NULL)
+	{
+		g_hash_table_destroy (indexes);
+		return;
+	}
+
+	variables = amp_am_scanner_get_variables (scanner);
+	header.variables = variables->len;
+	g_byte_array_prepend (data, (const guint8 *)&header, sizeof (header));
+	for (i = 0; i < variables->len; i++)
+	{
+		AmpAmVariable *var = &g_array_index (variables, AmpAmVariable, i);
+		AmpSnapshotVariable saved;
+
+		/* Tokens are not found if they have been removed from the tree */
+		saved.variable = var->variable;
+		saved.name = GPOINTER_TO_UINT (g_hash_table_lookup (indexes, var->name)) - 1;
+		saved.list = GPOINTER_TO_UINT (g_hash_table_lookup (indexes, var->list)) - 1;
+		if (((saved.name == -1) && (var->name != NULL)) || ((saved.list == -1) && (var->list != NULL))) break;
+		g_byte_array_append (data, (const guint8 *)&saved, sizeof (saved));
+	}
+	g_hash_table_destroy (indexes);
+
+	if (i == variables->len)
+	{
+		filename = amp_am_snapshot_get_filename (directory, makefile);
+		if (g_mkdir_with_parents (directory, 0755) == 0)
+		{
+			g_file_set_contents (filename, (const gchar *)data->data, data->len, NULL);
+		}
+		g_free (filename);
+	}
+	g_byte_array_free (data, TRUE);
+}
@@ -22,6 +22,7 @@
 #include "am-project.h"
 #include "mk-project.h"
 #include "libanjuta/anjuta-debug.h"
+#include "libanjuta/anjuta-directory-cache.h"
 #include "libanjuta/anjuta-project.h"
 #include "libanjuta/interfaces/ianjuta-project.h"
 
@@ -34,10 +35,14 @@
 
 static gchar* output_file = NULL;
 static FILE* output_stream = NULL;
+static gboolean show_time = FALSE;
+static gchar* snapshot_directory = NULL;
 
 static GOptionEntry entries[] =
 {
   { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output_file, "Output file (default stdout)", "output_file" },
+  { "time", 't', 0, G_OPTION_ARG_NONE, &show_time, "Display time used by each command", NULL },
+  { "snapshot", 's', 0, G_OPTION_ARG_FILENAME, &snapshot_directory, "Keep snapshots of parsed makefiles in this directory", "directory" },
   { NULL }
 };
 
@@ -71,10 +76,12 @@ void list_target (IAnjutaProject *project, AnjutaProjectTarget *target, gint ind
 	AnjutaProjectSource *source;
 	guint count = 0;
 	GFile *root;
+	gchar *group_path;
 
 	if (target == NULL) return;
 
 	root = anjuta_project_group_get_directory (ianjuta_project_get_root (project, NULL));
+	group_path = g_file_get_relative_path (root, anjuta_project_group_get_directory (anjuta_project_node_parent (target)));
 	
 	indent++;
 	print ("%*sTARGET (%s): %s", indent * INDENT, "", path, anjuta_project_target_get_name (target)); 
@@ -82,14 +89,25 @@ void list_target (IAnjutaProject *project, AnjutaProjectTarget *target, gint ind
 	for (source = anjuta_project_node_first_child (target); source != NULL; source = anjuta_project_node_next_sibling (source))
 	{
 		gchar *child_path = g_strdup_printf ("%s:%d", path, count);
-		GFile *child_file = anjuta_project_source_get_file (source);
-		gchar *rel_path = g_file_get_relative_path (root, child_file);
+		const gchar *name = anjuta_project_source_get_relative_path (source);
+		gchar *rel_path;
+
+		if ((name != NULL) && !g_path_is_absolute (name) && (strstr (name, "./") == NULL))
+		{
+			/* Avoid creating a file for simple relative names */
+			rel_path = group_path == NULL ? g_strdup (name) : g_build_filename (group_path, name, NULL);
+		}
+		else
+		{
+			rel_path = g_file_get_relative_path (root, anjuta_project_source_get_file (source));
+		}
 		
 		print ("%*sSOURCE (%s): %s", indent * INDENT, "", child_path, rel_path);
 		g_free (rel_path);
 		g_free (child_path);
 		count++;
 	}
+	g_free (group_path);
 }
 
 void list_group (IAnjutaProject *project, AnjutaProjectGroup *group, gint indent, const gchar *path)
@@ -202,6 +220,84 @@ void list_package (IAnjutaProject *project)
 	g_list_free (packages);
 }
 
+/* Dump the dependency graph of a make project, with a topological order,
+ * the longest chain of dependencies or a cycle */
+void list_graph (IAnjutaProject *project)
+{
+	MkpGraph *graph;
+	GArray *nodes;
+	GArray *cycle;
+	GString *line;
+	guint length;
+	guint node;
+	guint i;
+
+	if (!MKP_IS_PROJECT (project)) return;
+	graph = mkp_project_get_graph (MKP_PROJECT (project));
+	if (graph == NULL) return;
+
+	print ("GRAPH: %u nodes, %u edges", mkp_graph_get_node_count (graph), mkp_graph_get_edge_count (graph));
+	line = g_string_new (NULL);
+	for (node = 0; node < mkp_graph_get_node_count (graph); node++)
+	{
+		const guint *prerequisites;
+		guint count;
+
+		prerequisites = mkp_graph_get_prerequisites (graph, node, &count);
+		g_string_truncate (line, 0);
+		for (i = 0; i < count; i++)
+		{
+			g_string_append_printf (line, " %u", prerequisites[i]);
+		}
+		print ("%*sNODE (%u): %s:%s", INDENT, "", node, mkp_graph_get_node_name (graph, node), line->str);
+	}
+
+	nodes = g_array_new (FALSE, FALSE, sizeof (guint));
+	cycle = g_array_new (FALSE, FALSE, sizeof (guint));
+	if (mkp_graph_sort (graph, nodes, cycle))
+	{
+		g_string_truncate (line, 0);
+		for (i = 0; i < nodes->len; i++)
+		{
+			g_string_append_printf (line, " %s", mkp_graph_get_node_name (graph, g_array_index (nodes, guint, i)));
+		}
+		print ("%*sORDER:%s", INDENT, "", line->str);
+		
+		g_array_set_size (nodes, 0);
+		length = mkp_graph_get_critical_path (graph, nodes);
+		g_string_truncate (line, 0);
+		for (i = 0; i < nodes->len; i++)
+		{
+			g_string_append_printf (line, " %s", mkp_graph_get_node_name (graph, g_array_index (nodes, guint, i)));
+		}
+		print ("%*sCRITICAL PATH (%u):%s", INDENT, "", length, line->str);
+	}
+	else
+	{
+		g_string_truncate (line, 0);
+		for (i = 0; i < cycle->len; i++)
+		{
+			g_string_append_printf (line, " %s", mkp_graph_get_node_name (graph, g_array_index (cycle, guint, i)));
+		}
+		print ("%*sCYCLE:%s", INDENT, "", line->str);
+	}
+	g_array_free (cycle, TRUE);
+	g_array_free (nodes, TRUE);
+	g_string_free (line, TRUE);
+}
+
+void list_token (IAnjutaProject *project)
+{
+	if (AMP_IS_PROJECT (project))
+	{
+		guint count;
+		gsize length;
+
+		amp_project_get_token_stats (AMP_PROJECT (project), &count, &length);
+		print ("TOKENS: %u tokens, %" G_GSIZE_FORMAT " characters", count, length);
+	}
+}
+
 void list_variable (IAnjutaProject *project)
 {
 	if (MKP_IS_PROJECT (project))
@@ -211,7 +307,7 @@ void list_variable (IAnjutaProject *project)
 
 		for (var = g_list_first (variables); var != NULL; var = g_list_next (var))
 		{
-			gchar *value = mkp_variable_evaluate ((MkpVariable *)var->data, NULL);
+			gchar *value = mkp_variable_evaluate ((MkpVariable *)var->data, MKP_PROJECT (project));
 			
 			print ("%*sVARIABLE: %s = %s", INDENT, "", mkp_variable_get_name ((MkpVariable *)var->data), value);
 			g_free (value);
@@ -221,6 +317,65 @@ void list_variable (IAnjutaProject *project)
 }
 
 
+/* Return a name for node, relative to the project root directory */
+static gchar *
+get_node_name (IAnjutaProject *project, AnjutaProjectNode *node)
+{
+	GFile *root;
+	gchar *name = NULL;
+
+	root = g_file_get_parent (anjuta_project_group_get_directory (ianjuta_project_get_root (project, NULL)));
+	switch (anjuta_project_node_get_type (node))
+	{
+		case ANJUTA_PROJECT_GROUP:
+			name = g_file_get_relative_path (root, anjuta_project_group_get_directory (node));
+			break;
+		case ANJUTA_PROJECT_TARGET:
+			name = g_strdup (anjuta_project_target_get_name (node));
+			break;
+		case ANJUTA_PROJECT_SOURCE:
+			name = g_file_get_relative_path (root, anjuta_project_source_get_file (node));
+			break;
+		default:
+			break;
+	}
+	g_object_unref (root);
+
+	return name;
+}
+
+static void
+on_node_signal (IAnjutaProject *project, AnjutaProjectNode *node, const gchar *signal)
+{
+	static const gchar *types[] = {"UNKNOWN", "GROUP", "TARGET", "SOURCE"};
+	AnjutaProjectNodeType type = anjuta_project_node_get_type (node);
+	gchar *name;
+
+	name = get_node_name (project, node);
+	print ("SIGNAL: %s %s %s", signal, type <= ANJUTA_PROJECT_SOURCE ? types[type] : types[0], name);
+	g_free (name);
+}
+
+static void
+on_project_updated (IAnjutaProject *project, gpointer data)
+{
+	print ("SIGNAL: project-updated");
+}
+
+/* Run the main loop during delay milliseconds, to get file monitor events */
+static void
+wait_events (guint delay)
+{
+	GTimer *timer;
+
+	timer = g_timer_new ();
+	while (g_timer_elapsed (timer, NULL) * 1000 < delay)
+	{
+		if (!g_main_context_iteration (NULL, FALSE)) g_usleep (10000);
+	}
+	g_timer_destroy (timer);
+}
+
 static AnjutaProjectNode *
 get_node (IAnjutaProject *project, const char *path)
 {
@@ -346,8 +501,10 @@ main(int argc, char *argv[])
 	char **command;
 	GOptionContext *context;
 	GError *error = NULL;
+	GTimer *timer;
 
 	/* Initialize program */
+	if (!g_thread_supported ()) g_thread_init (NULL);
 	g_type_init ();
 	
 	anjuta_debug_init (FALSE);
@@ -367,8 +524,12 @@ main(int argc, char *argv[])
 	}
 
 	/* Execute commands */
+	timer = g_timer_new ();
 	for (command = &argv[1]; *command != NULL; command++)
 	{
+		const gchar *name = *command;
+
+		g_timer_start (timer);
 		if (g_ascii_strcasecmp (*command, "load") == 0)
 		{
 			GFile *file = g_file_new_for_commandline_arg (*(++command));
@@ -402,6 +563,7 @@ main(int argc, char *argv[])
 				else
 				{
 					project = IANJUTA_PROJECT (g_object_new (type, NULL));
+					if (AMP_IS_PROJECT (project)) amp_project_set_snapshot_directory (AMP_PROJECT (project), snapshot_directory);
 				}
 			}
 			
@@ -418,6 +580,69 @@ main(int argc, char *argv[])
 
 			list_group (project, ianjuta_project_get_root (project, NULL), 0, "0");
 		}
+		else if (g_ascii_strcasecmp (*command, "graph") == 0)
+		{
+			list_graph (project);
+		}
+		else if (g_ascii_strcasecmp (*command, "tokens") == 0)
+		{
+			list_token (project);
+		}
+		else if (g_ascii_strcasecmp (*command, "probe") == 0)
+		{
+			GFile *file = g_file_new_for_commandline_arg (*(++command));
+
+			print ("%s: %s", anjuta_directory_cache_query_exists (file) ? "FILE" : "NO FILE", *command);
+			g_object_unref (file);
+		}
+		else if (g_ascii_strcasecmp (*command, "run") == 0)
+		{
+			g_spawn_command_line_sync (*(++command), NULL, NULL, NULL, NULL);
+		}
+		else if (g_ascii_strcasecmp (*command, "wait") == 0)
+		{
+			wait_events (atoi (*(++command)));
+		}
+		else if (g_ascii_strcasecmp (*command, "watch") == 0)
+		{
+			g_signal_connect (G_OBJECT (project), "node-added", G_CALLBACK (on_node_signal), "node-added");
+			g_signal_connect (G_OBJECT (project), "node-removed", G_CALLBACK (on_node_signal), "node-removed");
+			g_signal_connect (G_OBJECT (project), "node-changed", G_CALLBACK (on_node_signal), "node-changed");
+			g_signal_connect (G_OBJECT (project), "project-updated", G_CALLBACK (on_project_updated), NULL);
+		}
+		else if (g_ascii_strcasecmp (*command, "id") == 0)
+		{
+			if (AMP_IS_PROJECT (project))
+			{
+				gchar *id = amp_project_get_node_id (AMP_PROJECT (project), *(++command));
+
+				print ("ID (%s): %s", *command, id == NULL ? "none" : id);
+				g_free (id);
+			}
+		}
+		else if (g_ascii_strcasecmp (*command, "find") == 0)
+		{
+			if (AMP_IS_PROJECT (project))
+			{
+				const gchar *id = *(++command);
+
+				node = amp_project_get_target (AMP_PROJECT (project), id);
+				if (node == NULL) node = amp_project_get_source (AMP_PROJECT (project), id);
+				if (node == NULL)
+				{
+					print ("NODE (%s): none", id);
+				}
+				else
+				{
+					gchar *name = get_node_name (project, node);
+					gchar *path = amp_project_get_node_path (AMP_PROJECT (project), id);
+
+					print ("NODE (%s): %s (%s) %s", id, anjuta_project_node_get_type (node) == ANJUTA_PROJECT_TARGET ? "TARGET" : "SOURCE", path, name);
+					g_free (path);
+					g_free (name);
+				}
+			}
+		}
 		else if (g_ascii_strcasecmp (*command, "move") == 0)
 		{
 			if (AMP_IS_PROJECT (project))
@@ -534,7 +759,12 @@ main(int argc, char *argv[])
 			g_error_free (error);
 			break;
 		}
+		if (show_time)
+		{
+			print ("TIME (%s): %.0f ms", name, g_timer_elapsed (timer, NULL) * 1000);
+		}
 	}
+	g_timer_destroy (timer);
 
 	/* Free objects */
 	if (project) g_object_unref (project);
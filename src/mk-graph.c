@@ -0,0 +1,357 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4; coding: utf-8 -*- */
+/* mk-graph.c
+ *
+ * Copyright (C) 2009  Sébastien Granjoux
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "mk-graph.h"
+
+#include <string.h>
+
+/* Dependency graph of a makefile. Each rule and each file is a node with an
+ * integer id, an edge goes from a target to one of its prerequisites. The
+ * edges are stored in a list and compiled into adjacency arrays when the
+ * graph is queried, so all algorithms are linear in the graph size.
+ */
+
+/* Graph object
+ *---------------------------------------------------------------------------*/
+
+typedef struct _MkpGraphEdge MkpGraphEdge;
+
+struct _MkpGraphEdge {
+	guint target;
+	guint prerequisite;
+};
+
+struct _MkpGraph {
+	GPtrArray *names;			/* Node names by id */
+	GHashTable *ids;			/* Node id + 1 by name */
+	GArray *edges;
+
+	/* Adjacency arrays, created when needed */
+	guint *prerequisites;		/* Prerequisites of all nodes */
+	guint *first_prerequisite;	/* Index in prerequisites, one more item */
+	guint *dependents;			/* Targets depending on all nodes */
+	guint *first_dependent;		/* Index in dependents, one more item */
+};
+
+/* Private functions
+ *---------------------------------------------------------------------------*/
+
+static void
+mkp_graph_clear_adjacency (MkpGraph *graph)
+{
+	g_free (graph->prerequisites);
+	graph->prerequisites = NULL;
+	g_free (graph->first_prerequisite);
+	graph->first_prerequisite = NULL;
+	g_free (graph->dependents);
+	graph->dependents = NULL;
+	g_free (graph->first_dependent);
+	graph->first_dependent = NULL;
+}
+
+static void
+mkp_graph_compile (MkpGraph *graph)
+{
+	guint nodes = graph->names->len;
+	guint edges = graph->edges->len;
+	guint *prerequisite_pos;
+	guint *dependent_pos;
+	guint i;
+
+	if (graph->first_prerequisite != NULL) return;
+
+	graph->first_prerequisite = g_new0 (guint, nodes + 1);
+	graph->first_dependent = g_new0 (guint, nodes + 1);
+	graph->prerequisites = g_new (guint, edges);
+	graph->dependents = g_new (guint, edges);
+
+	/* Count edges of each node, then compute the start of each list */
+	for (i = 0; i < edges; i++)
+	{
+		MkpGraphEdge *edge = &g_array_index (graph->edges, MkpGraphEdge, i);
+
+		graph->first_prerequisite[edge->target + 1]++;
+		graph->first_dependent[edge->prerequisite + 1]++;
+	}
+	for (i = 0; i < nodes; i++)
+	{
+		graph->first_prerequisite[i + 1] += graph->first_prerequisite[i];
+		graph->first_dependent[i + 1] += graph->first_dependent[i];
+	}
+
+	/* Fill the lists keeping the edges order */
+	prerequisite_pos = g_memdup (graph->first_prerequisite, nodes * sizeof (guint));
+	dependent_pos = g_memdup (graph->first_dependent, nodes * sizeof (guint));
+	for (i = 0; i < edges; i++)
+	{
+		MkpGraphEdge *edge = &g_array_index (graph->edges, MkpGraphEdge, i);
+
+		graph->prerequisites[prerequisite_pos[edge->target]++] = edge->prerequisite;
+		graph->dependents[dependent_pos[edge->prerequisite]++] = edge->target;
+	}
+	g_free (prerequisite_pos);
+	g_free (dependent_pos);
+}
+
+/* Find a cycle in the nodes not sorted, each of them has at least one
+ * prerequisite not sorted */
+static void
+mkp_graph_find_cycle (MkpGraph *graph, const guint *remaining, GArray *cycle)
+{
+	guint nodes = graph->names->len;
+	guint *visited;
+	guint start = cycle->len;
+	guint node;
+	guint step;
+
+	for (node = 0; (node < nodes) && (remaining[node] == 0); node++);
+	if (node == nodes) return;
+
+	/* Follow unsorted prerequisites until a node is found twice, visited
+	 * keeps the step + 1 of each node */
+	visited = g_new0 (guint, nodes);
+	for (step = 1; visited[node] == 0; step++)
+	{
+		guint i;
+		
+		visited[node] = step;
+		g_array_append_val (cycle, node);
+		for (i = graph->first_prerequisite[node]; remaining[graph->prerequisites[i]] == 0; i++);
+		node = graph->prerequisites[i];
+	}
+
+	/* Remove the path leading to the cycle and close it */
+	g_array_remove_range (cycle, start, visited[node] - 1);
+	g_array_append_val (cycle, node);
+	g_free (visited);
+}
+
+/* Public functions
+ *---------------------------------------------------------------------------*/
+
+/* Get the id of a node, creating it if needed. The name has to stay valid
+ * while the graph is used, by example interned in the project strings. */
+guint
+mkp_graph_add_node (MkpGraph *graph, const gchar *name)
+{
+	guint id;
+
+	id = GPOINTER_TO_UINT (g_hash_table_lookup (graph->ids, name));
+	if (id == 0)
+	{
+		g_ptr_array_add (graph->names, (gpointer)name);
+		id = graph->names->len;
+		g_hash_table_insert (graph->ids, (gpointer)name, GUINT_TO_POINTER (id));
+		mkp_graph_clear_adjacency (graph);
+	}
+
+	return id - 1;
+}
+
+void
+mkp_graph_add_edge (MkpGraph *graph, guint target, guint prerequisite)
+{
+	MkpGraphEdge edge = {target, prerequisite};
+
+	g_return_if_fail ((target < graph->names->len) && (prerequisite < graph->names->len));
+	
+	g_array_append_val (graph->edges, edge);
+	mkp_graph_clear_adjacency (graph);
+}
+
+guint
+mkp_graph_get_node_count (MkpGraph *graph)
+{
+	return graph->names->len;
+}
+
+guint
+mkp_graph_get_edge_count (MkpGraph *graph)
+{
+	return graph->edges->len;
+}
+
+const gchar *
+mkp_graph_get_node_name (MkpGraph *graph, guint node)
+{
+	g_return_val_if_fail (node < graph->names->len, NULL);
+	
+	return (const gchar *)g_ptr_array_index (graph->names, node);
+}
+
+const guint *
+mkp_graph_get_prerequisites (MkpGraph *graph, guint node, guint *count)
+{
+	g_return_val_if_fail (node < graph->names->len, NULL);
+
+	mkp_graph_compile (graph);
+	if (count != NULL) *count = graph->first_prerequisite[node + 1] - graph->first_prerequisite[node];
+
+	return graph->prerequisites + graph->first_prerequisite[node];
+}
+
+/* Append all nodes in order, prerequisites before their targets. If the
+ * graph has a cycle, only the nodes which can be sorted are appended, the
+ * cycle is appended in cycle if not NULL, starting and ending with the same
+ * node, and FALSE is returned. */
+gboolean
+mkp_graph_sort (MkpGraph *graph, GArray *order, GArray *cycle)
+{
+	guint nodes = graph->names->len;
+	guint *remaining;
+	guint start = order->len;
+	guint node;
+	guint i;
+
+	mkp_graph_compile (graph);
+
+	/* Count prerequisites not sorted yet, order is used as the queue */
+	remaining = g_new (guint, nodes);
+	for (node = 0; node < nodes; node++)
+	{
+		remaining[node] = graph->first_prerequisite[node + 1] - graph->first_prerequisite[node];
+		if (remaining[node] == 0) g_array_append_val (order, node);
+	}
+	for (i = start; i < order->len; i++)
+	{
+		guint j;
+		
+		node = g_array_index (order, guint, i);
+		for (j = graph->first_dependent[node]; j < graph->first_dependent[node + 1]; j++)
+		{
+			guint target = graph->dependents[j];
+
+			if (--remaining[target] == 0) g_array_append_val (order, target);
+		}
+	}
+
+	if ((order->len - start) < nodes)
+	{
+		if (cycle != NULL) mkp_graph_find_cycle (graph, remaining, cycle);
+		g_free (remaining);
+
+		return FALSE;
+	}
+	g_free (remaining);
+
+	return TRUE;
+}
+
+/* Get the number of nodes in the longest chain of dependencies, it is the
+ * minimum number of sequential steps needed to build everything. The chain is
+ * appended in path if not NULL, prerequisites first. Return 0 if the graph
+ * has a cycle. */
+guint
+mkp_graph_get_critical_path (MkpGraph *graph, GArray *path)
+{
+	GArray *order;
+	guint *depth;
+	guint *previous;
+	guint longest = 0;
+	guint last = 0;
+	guint i;
+
+	order = g_array_sized_new (FALSE, FALSE, sizeof (guint), graph->names->len);
+	if (!mkp_graph_sort (graph, order, NULL))
+	{
+		g_array_free (order, TRUE);
+
+		return 0;
+	}
+
+	depth = g_new (guint, graph->names->len);
+	previous = g_new (guint, graph->names->len);
+	for (i = 0; i < order->len; i++)
+	{
+		guint node = g_array_index (order, guint, i);
+		guint j;
+
+		/* Prerequisites are already done */
+		depth[node] = 1;
+		previous[node] = node;
+		for (j = graph->first_prerequisite[node]; j < graph->first_prerequisite[node + 1]; j++)
+		{
+			guint prerequisite = graph->prerequisites[j];
+
+			if (depth[prerequisite] + 1 > depth[node])
+			{
+				depth[node] = depth[prerequisite] + 1;
+				previous[node] = prerequisite;
+			}
+		}
+		if (depth[node] > longest)
+		{
+			longest = depth[node];
+			last = node;
+		}
+	}
+
+	if ((path != NULL) && (longest != 0))
+	{
+		guint start = path->len;
+		guint node;
+
+		g_array_set_size (path, start + longest);
+		for (node = last, i = longest; i > 0; node = previous[node])
+		{
+			g_array_index (path, guint, start + --i) = node;
+		}
+	}
+	
+	g_free (previous);
+	g_free (depth);
+	g_array_free (order, TRUE);
+
+	return longest;
+}
+
+/* Constructor & Destructor
+ *---------------------------------------------------------------------------*/
+
+MkpGraph *
+mkp_graph_new (void)
+{
+	MkpGraph *graph;
+
+	graph = g_slice_new0 (MkpGraph);
+	graph->names = g_ptr_array_new ();
+	graph->ids = g_hash_table_new (g_str_hash, g_str_equal);
+	graph->edges = g_array_new (FALSE, FALSE, sizeof (MkpGraphEdge));
+
+	return graph;
+}
+
+void
+mkp_graph_free (MkpGraph *graph)
+{
+	if (graph == NULL) return;
+	
+	mkp_graph_clear_adjacency (graph);
+	g_ptr_array_free (graph->names, TRUE);
+	g_hash_table_destroy (graph->ids);
+	g_array_free (graph->edges, TRUE);
+	g_slice_free (MkpGraph, graph);
+}
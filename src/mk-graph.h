@@ -0,0 +1,48 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4; coding: utf-8 -*- */
+/* mk-graph.h
+ *
+ * Copyright (C) 2009  Sébastien Granjoux
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#ifndef _MK_GRAPH_H_
+#define _MK_GRAPH_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _MkpGraph MkpGraph;
+
+MkpGraph *mkp_graph_new (void);
+void mkp_graph_free (MkpGraph *graph);
+
+guint mkp_graph_add_node (MkpGraph *graph, const gchar *name);
+void mkp_graph_add_edge (MkpGraph *graph, guint target, guint prerequisite);
+
+guint mkp_graph_get_node_count (MkpGraph *graph);
+guint mkp_graph_get_edge_count (MkpGraph *graph);
+const gchar *mkp_graph_get_node_name (MkpGraph *graph, guint node);
+const guint *mkp_graph_get_prerequisites (MkpGraph *graph, guint node, guint *count);
+
+gboolean mkp_graph_sort (MkpGraph *graph, GArray *order, GArray *cycle);
+guint mkp_graph_get_critical_path (MkpGraph *graph, GArray *path);
+
+G_END_DECLS
+
+#endif /* _MK_GRAPH_H_ */
@@ -24,6 +24,8 @@
 
 #include "mk-project.h"
 
+#include <libanjuta/anjuta-string-pool.h>
+
 G_BEGIN_DECLS
 
 struct _MkpProperty {
@@ -56,24 +58,41 @@ struct _MkpProject {
 	GHashTable		*groups;
 	GHashTable		*files;
 	GHashTable		*variables;
+	guint			variables_serial;	/* Changed when a variable is defined */
 
 	GHashTable		*rules;
 	GHashTable		*suffix;
+	GHashTable		*pattern_rules;		/* Source suffixes by target suffix */
+	GHashTable		*stem_rules;		/* % pattern rules by target suffix and prefix */
+	GList			*stem_rule_list;	/* % pattern rules, last defined first */
+	GHashTable		*sources;			/* Memoized source of each target */
+	gboolean		sources_partial;	/* Current source depends on the search depth */
+	MkpGraph		*graph;				/* Dependencies between rules and files */
 	
 	/* project files monitors */
 	GHashTable         *monitors;
+	GHashTable		*dirty;				/* Changed files -> deleted flag */
+	guint			dirty_timeout;		/* Pending update source id */
+	GTimeVal		dirty_since;		/* Time of the first pending event */
+	guint			monitor_delay;		/* Quiet time before update in ms */
+	guint			monitor_events;		/* Number of events received */
+	guint			monitor_reloads;	/* Number of project reloaded */
 
 	/* Keep list style */
 	AnjutaTokenStyle *space_list;
 	AnjutaTokenStyle *arg_list;
+
+	/* names used as hash table keys, kept until the project is unloaded */
+	AnjutaStringPool	*strings;
 };
 
 struct _MkpRule {
-	gchar *name;
+	const gchar *name;			/* Interned in project strings */
 	const gchar *part;
 	gboolean phony;
 	gboolean pattern;
-	GList *prerequisite;
+	gboolean stem;				/* GNU make pattern rule using % */
+	GList *prerequisite;		/* Interned names */
 	AnjutaToken *rule;
 };
 
@@ -82,7 +101,7 @@ gchar *mkp_project_token_evaluate (MkpProject *project, AnjutaToken *token);
 MkpTarget* mkp_target_new (const gchar *name, AnjutaProjectTargetType type);
 void mkp_target_free (MkpTarget *node);
 void mkp_target_add_token (MkpGroup *node, AnjutaToken *token);
-MkpSource* mkp_source_new (GFile *file);
+MkpSource* mkp_source_new (const gchar *name);
 
 G_END_DECLS
 
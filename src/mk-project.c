@@ -32,6 +32,7 @@
 #include <libanjuta/interfaces/ianjuta-project.h>
 #include <libanjuta/anjuta-debug.h>
 #include <libanjuta/anjuta-utils.h>
+#include <libanjuta/anjuta-directory-cache.h>
 
 #include <string.h>
 #include <memory.h>
@@ -56,6 +57,14 @@
 
 static const gchar *valid_makefiles[] = {"GNUmakefile", "makefile", "Makefile", NULL};
 
+/* Default time in milliseconds without monitor event before reloading the
+ * project */
+#define MKP_MONITOR_DELAY	250
+
+/* Maximum number of monitor delays before updating the project if events are
+ * received continuously */
+#define MKP_MONITOR_MAX_DELAYS	4
+
 /* convenient shortcut macro the get the MkpNode from a GNode */
 #define MKP_NODE_DATA(node)  ((node) != NULL ? (AnjutaProjectNodeData *)((node)->data) : NULL)
 #define MKP_GROUP_DATA(node)  ((node) != NULL ? (MkpGroupData *)((node)->data) : NULL)
@@ -64,9 +73,13 @@ static const gchar *valid_makefiles[] = {"GNUmakefile", "makefile", "Makefile",
 
 
 struct _MkpVariable {
-	gchar *name;
+	const gchar *name;			/* Interned in project strings */
 	AnjutaTokenType assign;
 	AnjutaToken *value;
+	GArray *tokens;				/* Value split in tokens, created when needed */
+	gchar *evaluated;			/* Expanded value, created when needed */
+	guint serial;				/* Project variables serial of evaluated */
+	gboolean evaluating;		/* Check recursive references */
 };
 
 typedef enum {
@@ -228,32 +241,8 @@ get_relative_path (GFile *parent, GFile *file)
 static GFileType
 file_type (GFile *file, const gchar *filename)
 {
-	GFile *child;
-	GFileInfo *info;
-	GFileType type;
-
-	child = filename != NULL ? g_file_get_child (file, filename) : g_object_ref (file);
-
-	//g_message ("check file %s", g_file_get_path (child));
-	
-	info = g_file_query_info (child,
-	                          G_FILE_ATTRIBUTE_STANDARD_TYPE, 
-	                          G_FILE_QUERY_INFO_NONE,
-	                          NULL,
-	                          NULL);
-	if (info != NULL)
-	{
-		type = g_file_info_get_file_type (info);
-		g_object_unref (info);
-	}
-	else
-	{
-		type = G_FILE_TYPE_UNKNOWN;
-	}
-	
-	g_object_unref (child);
-	
-	return type;
+	/* Use the directory cache, a directory is read only once */
+	return anjuta_directory_cache_get_file_type (file, filename);
 }
 
 /* Group objects
@@ -332,9 +321,8 @@ mkp_group_free (MkpGroup *node)
 	{
 		if (group->tokens[i] != NULL) g_list_free (group->tokens[i]);
 	}
+	anjuta_project_node_destroy (node);
     g_slice_free (MkpGroupData, group);
-
-	g_node_destroy (node);
 }
 
 /* Target objects
@@ -384,22 +372,23 @@ mkp_target_free (MkpTarget *node)
 	
     g_free (target->base.name);
     g_free (target->install);
+	anjuta_project_node_destroy (node);
     g_slice_free (MkpTargetData, target);
-
-	g_node_destroy (node);
 }
 
 /* Source objects
  *---------------------------------------------------------------------------*/
 
+/* The name is relative to the group directory and has to be interned in the
+ * project, the file is created only when needed */
 MkpSource*
-mkp_source_new (GFile *file)
+mkp_source_new (const gchar *name)
 {
     MkpSourceData *source = NULL;
 
 	source = g_slice_new0(MkpSourceData); 
 	source->base.node.type = ANJUTA_PROJECT_SOURCE;
-	source->base.file = g_object_ref (file);
+	source->base.name = name;
 
     return g_node_new (source);
 }
@@ -409,16 +398,96 @@ mkp_source_free (MkpSource *node)
 {
     MkpSourceData *source = MKP_SOURCE_DATA (node);
 	
-    g_object_unref (source->base.file);
+	if (source->base.file != NULL) g_object_unref (source->base.file);
+	anjuta_project_node_destroy (node);
     g_slice_free (MkpSourceData, source);
-
-	g_node_destroy (node);
 }
 
 /*
  * File monitoring support --------------------------------
  * FIXME: review these
  */
+
+/* Check if one of the changed files can modify the project. Files of the
+ * project rewritten with the same content are not considered as changed. The
+ * directory of any other file is read again but the file changes the project
+ * only if it can change the result of the rules */
+static gboolean
+mkp_project_is_changed (MkpProject *project, GHashTable *dirty)
+{
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+
+	if (project->files == NULL) return TRUE;
+
+	g_hash_table_iter_init (&iter, dirty);
+	while (g_hash_table_iter_next (&iter, &key, &value))
+	{
+		AnjutaTokenFile *tfile;
+
+		tfile = (AnjutaTokenFile *)g_hash_table_lookup (project->files, key);
+		if (tfile == NULL)
+		{
+			GFile *directory;
+			gchar *name;
+			gboolean used;
+
+			directory = g_file_get_parent ((GFile *)key);
+			if (directory != NULL)
+			{
+				anjuta_directory_cache_invalidate (directory);
+				g_object_unref (directory);
+			}
+
+			/* Other files, like objects written by make, only change the
+			 * directory content */
+			name = g_file_get_relative_path (project->root_file, (GFile *)key);
+			used = (name != NULL) && mkp_project_is_rule_file (project, name);
+			g_free (name);
+			if (used) return TRUE;
+		}
+		else
+		{
+			gchar *content;
+			gsize length;
+			gboolean same;
+
+			if (GPOINTER_TO_INT (value)) return TRUE;
+			if (!g_file_load_contents ((GFile *)key, NULL, &content, &length, NULL, NULL)) return TRUE;
+			same = anjuta_token_file_is_same_content (tfile, content, length);
+			g_free (content);
+			if (!same) return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/* Reload the project once no monitor event has been received during the
+ * monitor delay */
+static gboolean
+mkp_project_refresh_dirty (gpointer data)
+{
+	MkpProject *project = (MkpProject *)data;
+	GHashTable *dirty;
+
+	/* Reloading the project clears the pending events */
+	dirty = project->dirty;
+	project->dirty = g_hash_table_new_full (g_file_hash, (GEqualFunc)g_file_equal, g_object_unref, NULL);
+	project->dirty_timeout = 0;
+
+	if (mkp_project_is_changed (project, dirty))
+	{
+		mkp_project_reload (project, NULL);
+		project->monitor_reloads++;
+		g_signal_emit_by_name (G_OBJECT (project), "project-updated");
+	}
+	g_hash_table_destroy (dirty);
+
+	return FALSE;
+}
+
 static void
 monitor_cb (GFileMonitor *monitor,
 			GFile *file,
@@ -427,15 +496,45 @@ monitor_cb (GFileMonitor *monitor,
 			gpointer data)
 {
 	MkpProject *project = data;
+	GFile *directory;
+	GTimeVal now;
 
 	g_return_if_fail (project != NULL && MKP_IS_PROJECT (project));
 
+	/* Directory content is changed */
+	directory = g_file_get_parent (file);
+	if (directory != NULL)
+	{
+		anjuta_directory_cache_invalidate (directory);
+		g_object_unref (directory);
+	}
+
 	switch (event_type) {
 		case G_FILE_MONITOR_EVENT_CHANGED:
 		case G_FILE_MONITOR_EVENT_DELETED:
-			/* monitor will be removed here... is this safe? */
-			mkp_project_reload (project, NULL);
-			g_signal_emit_by_name (G_OBJECT (project), "project-updated");
+			/* Wait until no event is received during the monitor delay, but not
+			 * more than a few delays */
+			project->monitor_events++;
+			if ((event_type == G_FILE_MONITOR_EVENT_DELETED) || (g_hash_table_lookup (project->dirty, file) == NULL))
+			{
+				g_hash_table_replace (project->dirty, g_object_ref (file), GINT_TO_POINTER (event_type == G_FILE_MONITOR_EVENT_DELETED));
+			}
+			g_get_current_time (&now);
+			if (project->dirty_timeout == 0)
+			{
+				project->dirty_since = now;
+			}
+			else
+			{
+				glong elapsed;
+
+				/* Keep the pending update if it would be delayed more than
+				 * the maximum delay after the first event */
+				elapsed = (now.tv_sec - project->dirty_since.tv_sec) * 1000 + (now.tv_usec - project->dirty_since.tv_usec) / 1000;
+				if (elapsed + (glong)project->monitor_delay > (glong)project->monitor_delay * MKP_MONITOR_MAX_DELAYS) break;
+				g_source_remove (project->dirty_timeout);
+			}
+			project->dirty_timeout = g_timeout_add (project->monitor_delay, mkp_project_refresh_dirty, project);
 			break;
 		default:
 			break;
@@ -462,10 +561,22 @@ monitor_add (MkpProject *project, GFile *file)
 		exists = g_file_query_exists (file, NULL);
 		
 		if (exists) {
-			monitor = g_file_monitor_file (file, 
-						       G_FILE_MONITOR_NONE,
-						       NULL,
-						       NULL);
+			/* Group directories are monitored to get changes of
+			 * all their files */
+			if (file_type (file, NULL) == G_FILE_TYPE_DIRECTORY)
+			{
+				monitor = g_file_monitor_directory (file, 
+							       G_FILE_MONITOR_NONE,
+							       NULL,
+							       NULL);
+			}
+			else
+			{
+				monitor = g_file_monitor_file (file, 
+							       G_FILE_MONITOR_NONE,
+							       NULL,
+							       NULL);
+			}
 			if (monitor != NULL)
 			{
 				g_signal_connect (G_OBJECT (monitor),
@@ -488,6 +599,11 @@ monitors_remove (MkpProject *project)
 	if (project->monitors)
 		g_hash_table_destroy (project->monitors);
 	project->monitors = NULL;
+
+	/* Drop pending events */
+	if (project->dirty_timeout != 0) g_source_remove (project->dirty_timeout);
+	project->dirty_timeout = 0;
+	if (project->dirty != NULL) g_hash_table_remove_all (project->dirty);
 }
 
 static void
@@ -537,7 +653,7 @@ mkp_dump_node (AnjutaProjectNode *g_node)
 			DEBUG_PRINT ("TARGET: %s", name);
 			break;
 		case ANJUTA_PROJECT_SOURCE:
-			name = g_file_get_uri (MKP_SOURCE_DATA (g_node)->base.file);
+			name = g_file_get_uri (anjuta_project_source_get_file (g_node));
 			DEBUG_PRINT ("SOURCE: %s", name);
 			break;
 		default:
@@ -626,10 +742,12 @@ project_load_makefile (MkpProject *project, GFile *file, MkpGroup *parent, GErro
 	g_hash_table_insert (project->files, g_object_ref (file), g_object_ref (tfile));
 //	g_object_add_toggle_ref (G_OBJECT (project->make_file), remove_make_file, project);
 	arg = anjuta_token_file_load (tfile, NULL);
+	anjuta_token_pool_push (anjuta_token_file_get_pool (tfile));
 	scanner = mkp_scanner_new (project);
 	parse = mkp_scanner_parse_token (scanner, arg, &err);
 	ok = parse != NULL;
 	mkp_scanner_free (scanner);
+	anjuta_token_pool_pop ();
 	if (!ok)
 	{
 		g_set_error (error, IANJUTA_PROJECT_ERROR, 
@@ -675,7 +793,7 @@ mkp_project_get_variable (MkpProject *project, const gchar *name)
 {
 	MkpVariable *var;
 	
-	var = (MkpVariable *)g_hash_table_lookup (project->groups, name);
+	var = (MkpVariable *)g_hash_table_lookup (project->variables, name);
 
 	return var;
 }
@@ -763,6 +881,19 @@ mkp_project_get_node_id (MkpProject *project, const gchar *path)
 	}
 }
 
+/* Return the path of the node having this id, the inverse of
+ * mkp_project_get_node_id */
+gchar *
+mkp_project_get_node_path (MkpProject *project, const gchar *id)
+{
+	AnjutaProjectNode *node;
+
+	node = mkp_project_get_group (project, id);
+	if (node == NULL) node = mkp_project_get_target (project, id);
+
+	return node != NULL ? anjuta_project_node_get_path (node) : NULL;
+}
+
 gchar *
 mkp_project_get_uri (MkpProject *project)
 {
@@ -798,20 +929,16 @@ mkp_project_get_target_types (MkpProject *project, GError **error)
 gboolean
 mkp_project_get_token_location (MkpProject *project, AnjutaTokenFileLocation *location, AnjutaToken *token)
 {
-	GHashTableIter iter;
-	gpointer key;
-	gpointer value;
+	AnjutaTokenFile *tfile;
 
-	g_hash_table_iter_init (&iter, project->files);
-	while (g_hash_table_iter_next (&iter, &key, &value))
+	/* Check that the file containing the token belongs to this project */
+	tfile = anjuta_token_file_lookup (token);
+	if ((tfile == NULL) || (g_hash_table_lookup (project->files, anjuta_token_file_get_file (tfile)) != tfile))
 	{
-		if (anjuta_token_file_get_token_location ((AnjutaTokenFile *)value, location, token))
-		{
-			return TRUE;
-		}
+		return FALSE;
 	}
 
-	return FALSE;
+	return anjuta_token_file_get_token_location (tfile, location, token);
 }
 
 /* Group access functions
@@ -868,7 +995,7 @@ mkp_source_get_id (MkpSource *source)
 GFile*
 mkp_source_get_file (MkpSource *source)
 {
-	return MKP_SOURCE_DATA (source)->base.file;
+	return anjuta_project_source_get_file (source);
 }
 
 /* Variable access functions
@@ -880,21 +1007,65 @@ mkp_variable_get_name (MkpVariable *variable)
 	return variable->name;
 }
 
+/* The expanded value of a simply expanded variable is computed when the
+ * variable is defined. A recursively expanded variable can depend on any
+ * other variable, its value is computed again when any variable changes. */
 gchar *
 mkp_variable_evaluate (MkpVariable *variable, MkpProject *project)
 {
-	return anjuta_token_evaluate (variable->value);
+	if (project == NULL) return anjuta_token_evaluate (variable->value);
+
+	if ((variable->evaluated == NULL) || ((variable->assign != MK_TOKEN_IMMEDIATE_EQUAL) && (variable->serial != project->variables_serial)))
+	{
+		if (variable->evaluating)
+		{
+			g_warning ("Variable %s references itself", variable->name);
+			
+			return NULL;
+		}
+		variable->evaluating = TRUE;
+		g_free (variable->evaluated);
+		variable->evaluated = mkp_scanner_evaluate_tokens (project, mkp_variable_get_tokens (variable, project));
+		variable->serial = project->variables_serial;
+		variable->evaluating = FALSE;
+	}
+
+	return g_strdup (variable->evaluated);
+}
+
+/* Get the value of the variable split in tokens, references to other
+ * variables are kept except for simply expanded variables. The tokens are
+ * owned by the variable. */
+GArray *
+mkp_variable_get_tokens (MkpVariable *variable, MkpProject *project)
+{
+	if (variable->tokens == NULL)
+	{
+		variable->tokens = mkp_scanner_tokenize (project, variable->value);
+	}
+
+	return variable->tokens;
+}
+
+static void
+mkp_variable_clear_cache (MkpVariable *variable)
+{
+	if (variable->tokens != NULL) g_array_free (variable->tokens, TRUE);
+	variable->tokens = NULL;
+	g_free (variable->evaluated);
+	variable->evaluated = NULL;
 }
 
+/* The name has to be interned in the project strings */
 static MkpVariable*
-mkp_variable_new (gchar *name, AnjutaTokenType assign, AnjutaToken *value)
+mkp_variable_new (const gchar *name, AnjutaTokenType assign, AnjutaToken *value)
 {
     MkpVariable *variable = NULL;
 
 	g_return_val_if_fail (name != NULL, NULL);
 	
 	variable = g_slice_new0(MkpVariable); 
-	variable->name = g_strdup (name);
+	variable->name = name;
 	variable->assign = assign;
 	variable->value = value;
 
@@ -904,8 +1075,7 @@ mkp_variable_new (gchar *name, AnjutaTokenType assign, AnjutaToken *value)
 static void
 mkp_variable_free (MkpVariable *variable)
 {
-	g_free (variable->name);
-	
+	mkp_variable_clear_cache (variable);
     g_slice_free (MkpVariable, variable);
 }
 
@@ -916,18 +1086,17 @@ void
 mkp_project_update_variable (MkpProject *project, AnjutaToken *variable)
 {
 	AnjutaToken *arg;
-	char *name = NULL;
+	const gchar *name = NULL;
+	gchar *value_name;
 	MakeTokenType assign = 0;	
 	AnjutaToken *value = NULL;
 
-	fprintf(stdout, "update variable");
-	anjuta_token_dump (variable);
-	
 	arg = anjuta_token_first_item (variable);
-	name = g_strstrip (anjuta_token_evaluate (arg));
+	value_name = anjuta_token_evaluate (arg);
+	if (value_name == NULL) return;
+	name = anjuta_string_pool_intern_take (project->strings, g_strstrip (value_name));
 	arg = anjuta_token_next_item (arg);
 	
-	g_message ("new variable %s", name);
 	switch (anjuta_token_get_type (arg))
 	{
 	case MK_TOKEN_EQUAL:
@@ -945,48 +1114,65 @@ mkp_project_update_variable (MkpProject *project, AnjutaToken *variable)
 	if (assign != 0)
 	{
 		MkpVariable *var;
+		GArray *tokens = NULL;
 
-		g_message ("assign %d name %s value %s\n", assign, name, anjuta_token_evaluate (value));
+		if (assign == MK_TOKEN_IMMEDIATE_EQUAL)
+		{
+			/* Expand the value now, using the previous definitions */
+			GArray *value_tokens = mkp_scanner_tokenize (project, value);
+			
+			tokens = mkp_scanner_expand_tokens (project, value_tokens);
+			g_array_free (value_tokens, TRUE);
+		}
+		
 		var = (MkpVariable *)g_hash_table_lookup (project->variables, name);
 		if (var != NULL)
 		{
+			mkp_variable_clear_cache (var);
 			var->assign = assign;
 			var->value = value;
 		}
 		else
 		{
 			var = mkp_variable_new (name, assign, value);
-			g_hash_table_insert (project->variables, var->name, var);
+			g_hash_table_insert (project->variables, (gpointer)var->name, var);
 		}
-
+		var->tokens = tokens;
+		project->variables_serial++;
 	}
-
-	g_message ("update variable %s", name);
-	
-	if (name) g_free (name);
 }
 
-AnjutaToken*
-mkp_project_get_variable_token (MkpProject *project, AnjutaToken *variable)
+/* Find a variable from a reference like $(NAME), ${NAME} or $N */
+MkpVariable*
+mkp_project_find_variable (MkpProject *project, const gchar *reference, gsize length)
 {
-	guint length;
-	const gchar *string;
 	gchar *name;
 	MkpVariable *var;
-		
-	length = anjuta_token_get_length (variable);
-	string = anjuta_token_get_string (variable);
-	if (string[1] == '(')
+
+	if ((reference == NULL) || (length < 2)) return NULL;
+	
+	if ((reference[1] == '(') || (reference[1] == '{'))
 	{
-		name = g_strndup (string + 2, length - 3);
+		if (length < 4) return NULL;
+		name = g_strndup (reference + 2, length - 3);
 	}
 	else
 	{
-		name = g_strndup (string + 1, 1);
+		name = g_strndup (reference + 1, 1);
 	}
 	var = g_hash_table_lookup (project->variables, name);
 	g_free (name);
 
+	return var;
+}
+
+AnjutaToken*
+mkp_project_get_variable_token (MkpProject *project, AnjutaToken *variable)
+{
+	MkpVariable *var;
+		
+	var = mkp_project_find_variable (project, anjuta_token_get_string (variable), anjuta_token_get_length (variable));
+
 	return var != NULL ? var->value : NULL;
 }
 
@@ -1005,8 +1191,15 @@ mkp_project_reload (MkpProject *project, GError **error)
 	project->root_file = root_file;
 	DEBUG_PRINT ("reload project %p root file %p", project, project->root_file);
 
+	/* Files could have been changed outside, read all project directories
+	 * again */
+	anjuta_directory_cache_invalidate_tree (root_file);
+
+	/* A new string pool for each load */
+	project->strings = anjuta_string_pool_new ();
+
 	/* shortcut hash tables */
-	project->groups = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	project->groups = g_hash_table_new (g_str_hash, g_str_equal);
 	project->files = g_hash_table_new_full (g_file_hash, (GEqualFunc)g_file_equal, g_object_unref, g_object_unref);
 	project->variables = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify)mkp_variable_free);
 
@@ -1037,7 +1230,7 @@ mkp_project_reload (MkpProject *project, GError **error)
 
 	/* Create group */
 	group = mkp_group_new (root_file);
-	g_hash_table_insert (project->groups, g_file_get_uri (root_file), group);
+	g_hash_table_insert (project->groups, (gpointer)anjuta_string_pool_intern_take (project->strings, g_file_get_uri (root_file)), group);
 	project->root_node = group;
 
 	
@@ -1093,6 +1286,47 @@ mkp_project_unload (MkpProject *project)
 	/* List styles */
 	if (project->space_list) anjuta_token_style_free (project->space_list);
 	if (project->arg_list) anjuta_token_style_free (project->arg_list);
+
+	/* All names, including the ones only tried as sources */
+	anjuta_string_pool_free (project->strings);
+	project->strings = NULL;
+}
+
+/* Set the time in milliseconds without file change needed before reloading
+ * the project, all changes received in between are handled at once. If files
+ * keep changing, the project is reloaded after MKP_MONITOR_MAX_DELAYS delays */
+void
+mkp_project_set_monitor_delay (MkpProject *project, guint delay)
+{
+	g_return_if_fail (MKP_IS_PROJECT (project));
+
+	project->monitor_delay = delay;
+}
+
+void
+mkp_project_get_monitor_stats (MkpProject *project, guint *events, guint *reloads)
+{
+	g_return_if_fail (MKP_IS_PROJECT (project));
+
+	if (events != NULL) *events = project->monitor_events;
+	if (reloads != NULL) *reloads = project->monitor_reloads;
+}
+
+/* Get the number of distinct names kept by the project and the memory saved
+ * by sharing them */
+void
+mkp_project_get_string_stats (MkpProject *project, guint *count, gsize *saved)
+{
+	g_return_if_fail (MKP_IS_PROJECT (project));
+
+	anjuta_string_pool_get_stats (project->strings, count, saved);
+}
+
+/* Keep a string until the project is unloaded, the value is freed */
+const gchar *
+mkp_project_intern_string (MkpProject *project, gchar *value)
+{
+	return value == NULL ? NULL : anjuta_string_pool_intern_take (project->strings, value);
 }
 
 gint
@@ -1169,7 +1403,7 @@ mkp_project_move (MkpProject *project, const gchar *path)
 
 	/* Change project root directory in groups */
 	old_hash = project->groups;
-	project->groups = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	project->groups = g_hash_table_new (g_str_hash, g_str_equal);
 	g_hash_table_iter_init (&iter, old_hash);
 	while (g_hash_table_iter_next (&iter, &key, &value))
 	{
@@ -1181,7 +1415,7 @@ mkp_project_move (MkpProject *project, const gchar *path)
 		g_object_unref (MKP_GROUP_DATA (group)->base.directory);
 		MKP_GROUP_DATA (group)->base.directory = new_file;
 
-		g_hash_table_insert (project->groups, g_file_get_uri (new_file), group);
+		g_hash_table_insert (project->groups, (gpointer)anjuta_string_pool_intern_take (project->strings, g_file_get_uri (new_file)), group);
 	}
 	g_hash_table_destroy (old_hash);
 
@@ -1307,6 +1541,8 @@ mkp_project_dispose (GObject *object)
 	g_return_if_fail (MKP_IS_PROJECT (object));
 
 	mkp_project_unload (MKP_PROJECT (object));
+	if (MKP_PROJECT (object)->dirty != NULL) g_hash_table_destroy (MKP_PROJECT (object)->dirty);
+	MKP_PROJECT (object)->dirty = NULL;
 
 	G_OBJECT_CLASS (parent_class)->dispose (object);	
 }
@@ -1326,6 +1562,14 @@ mkp_project_instance_init (MkpProject *project)
 
 	project->space_list = NULL;
 	project->arg_list = NULL;
+
+	project->dirty = g_hash_table_new_full (g_file_hash, (GEqualFunc)g_file_equal, g_object_unref, NULL);
+	project->dirty_timeout = 0;
+	project->monitor_delay = MKP_MONITOR_DELAY;
+	project->monitor_events = 0;
+	project->monitor_reloads = 0;
+
+	project->strings = NULL;
 }
 
 static void
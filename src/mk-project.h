@@ -29,6 +29,8 @@
 #include <libanjuta/anjuta-token-file.h>
 #include <libanjuta/anjuta-token-list.h>
 
+#include "mk-graph.h"
+
 G_BEGIN_DECLS
 
 //#define YYSTYPE AnjutaToken*
@@ -75,13 +77,20 @@ gboolean mkp_project_load (MkpProject *project, GFile *directory, GError **error
 gboolean mkp_project_reload (MkpProject *project, GError **error);
 void mkp_project_unload (MkpProject *project);
 
+void mkp_project_set_monitor_delay (MkpProject *project, guint delay);
+void mkp_project_get_monitor_stats (MkpProject *project, guint *events, guint *reloads);
+void mkp_project_get_string_stats (MkpProject *project, guint *count, gsize *saved);
+const gchar *mkp_project_intern_string (MkpProject *project, gchar *value);
+
 MkpGroup *mkp_project_get_root (MkpProject *project);
 MkpVariable *mkp_project_get_variable (MkpProject *project, const gchar *name);
 GList *mkp_project_list_variable (MkpProject *project);
+MkpVariable *mkp_project_find_variable (MkpProject *project, const gchar *reference, gsize length);
 AnjutaToken* mkp_project_get_variable_token (MkpProject *project, AnjutaToken *variable);
 
 void mkp_project_update_variable (MkpProject *project, AnjutaToken *variable);
 void mkp_project_add_rule (MkpProject *project, AnjutaToken *rule);
+MkpGraph *mkp_project_get_graph (MkpProject *project);
 
 MkpGroup *mkp_project_get_group (MkpProject *project, const gchar *id);
 MkpTarget *mkp_project_get_target (MkpProject *project, const gchar *id);
@@ -104,6 +113,7 @@ MkpSource* mkp_project_add_source (MkpProject  *project, MkpTarget *target, cons
 void mkp_project_remove_source (MkpProject  *project, MkpSource *source, GError **error);
 
 gchar * mkp_project_get_node_id (MkpProject *project, const gchar *path);
+gchar * mkp_project_get_node_path (MkpProject *project, const gchar *id);
 
 GFile *mkp_group_get_directory (MkpGroup *group);
 GFile *mkp_group_get_makefile (MkpGroup *group);
@@ -117,6 +127,7 @@ gchar *mkp_source_get_id (MkpSource *source);
 GFile *mkp_source_get_file (MkpSource *source);
 
 gchar *mkp_variable_evaluate (MkpVariable *variable, MkpProject *project);
+GArray *mkp_variable_get_tokens (MkpVariable *variable, MkpProject *project);
 const gchar* mkp_variable_get_name (MkpVariable *variable);
 
 
@@ -29,6 +29,8 @@
 #include "mk-project-private.h"
 #include "mk-scanner.h"
 
+#include <libanjuta/anjuta-directory-cache.h>
+
 #include <string.h>
 #include <stdio.h>
 
@@ -38,18 +40,46 @@
 /* Maximum level of dependencies when searching for source files */
 #define MAX_DEPENDENCIES	16
 
+/* Memoized source of a target being checked */
+#define MKP_SOURCE_CHECKING	((gpointer)&mkp_source_checking)
+
+static const gchar mkp_source_checking;
+
+/* GNU make pattern rule, split around the % of the target and of the first
+ * prerequisite */
+typedef struct _MkpStemRule MkpStemRule;
+
+struct _MkpStemRule {
+	const gchar *prefix;		/* All strings are interned */
+	const gchar *suffix;
+	const gchar *source_prefix;
+	const gchar *source_suffix;
+	gsize prefix_length;
+	gsize suffix_length;
+};
+
+/* GNU make pattern rules having the same target suffix, indexed by target
+ * prefix */
+typedef struct _MkpStemBucket MkpStemBucket;
+
+struct _MkpStemBucket {
+	GHashTable *prefixes;		/* Rule lists by prefix, in makefile order */
+	GArray *lengths;			/* Distinct prefix lengths, longest first */
+};
+
 /* Rule object
  *---------------------------------------------------------------------------*/
 
+/* The name has to be interned in the project strings */
 static MkpRule*
-mkp_rule_new (gchar *name, AnjutaToken *token)
+mkp_rule_new (const gchar *name, AnjutaToken *token)
 {
     MkpRule *rule = NULL;
 
 	g_return_val_if_fail (name != NULL, NULL);
 	
 	rule = g_slice_new0(MkpRule); 
-	rule->name = g_strdup (name);
+	rule->name = name;
 	rule->rule = token;
 
 	return rule;
@@ -58,89 +88,384 @@ mkp_rule_new (gchar *name, AnjutaToken *token)
 static void
 mkp_rule_free (MkpRule *rule)
 {
-	g_free (rule->name);
-	g_list_foreach (rule->prerequisite, (GFunc)g_free, NULL);
 	g_list_free (rule->prerequisite);
 	
     g_slice_free (MkpRule, rule);
 }
 
+/* Stem rule object
+ *---------------------------------------------------------------------------*/
+
+static MkpStemRule*
+mkp_stem_rule_new (MkpProject *project, const gchar *target, const gchar *source)
+{
+	MkpStemRule *rule;
+	const gchar *percent;
+
+	rule = g_slice_new0 (MkpStemRule);
+	percent = strchr (target, '%');
+	rule->prefix = anjuta_string_pool_intern_take (project->strings, g_strndup (target, percent - target));
+	rule->prefix_length = percent - target;
+	rule->suffix = anjuta_string_pool_intern (project->strings, percent + 1);
+	rule->suffix_length = strlen (rule->suffix);
+	percent = strchr (source, '%');
+	rule->source_prefix = anjuta_string_pool_intern_take (project->strings, g_strndup (source, percent - source));
+	rule->source_suffix = anjuta_string_pool_intern (project->strings, percent + 1);
+
+	return rule;
+}
+
+static void
+mkp_stem_rule_list_free (GList *list)
+{
+	GList *item;
+
+	for (item = list; item != NULL; item = g_list_next (item))
+	{
+		g_slice_free (MkpStemRule, item->data);
+	}
+	g_list_free (list);
+}
+
+static MkpStemBucket*
+mkp_stem_bucket_new (void)
+{
+	MkpStemBucket *bucket;
+
+	bucket = g_slice_new (MkpStemBucket);
+	bucket->prefixes = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify)g_list_free);
+	bucket->lengths = g_array_new (FALSE, FALSE, sizeof (gsize));
+
+	return bucket;
+}
+
+static void
+mkp_stem_bucket_free (MkpStemBucket *bucket)
+{
+	g_hash_table_destroy (bucket->prefixes);
+	g_array_free (bucket->lengths, TRUE);
+	g_slice_free (MkpStemBucket, bucket);
+}
+
+/* Add a rule after all rules of the bucket having the same prefix */
+static void
+mkp_stem_bucket_add (MkpStemBucket *bucket, MkpStemRule *rule)
+{
+	GList *list;
+	guint i;
+
+	list = g_hash_table_lookup (bucket->prefixes, rule->prefix);
+	if (list != NULL)
+	{
+		/* The list head does not change */
+		g_list_append (list, rule);
+
+		return;
+	}
+	g_hash_table_insert (bucket->prefixes, (gpointer)rule->prefix, g_list_append (NULL, rule));
+
+	for (i = 0; (i < bucket->lengths->len) && (g_array_index (bucket->lengths, gsize, i) > rule->prefix_length); i++);
+	if ((i == bucket->lengths->len) || (g_array_index (bucket->lengths, gsize, i) != rule->prefix_length))
+	{
+		g_array_insert_val (bucket->lengths, i, rule->prefix_length);
+	}
+}
+
 /* Private functions
  *---------------------------------------------------------------------------*/
 
-/* Find a source for target checking pattern rule. If no source is found,
- * return target, else free target and return a newly allocated source name */
+/* Check if a file exists using the cached directory listing */
+static gboolean
+mkp_project_source_exists (AnjutaProjectGroup *parent, const gchar *name)
+{
+	GFile *directory = anjuta_project_group_get_directory (parent);
+	
+	if (strchr (name, G_DIR_SEPARATOR) != NULL)
+	{
+		GFile *child;
+		gboolean exist;
 
-gchar *
-mkp_project_find_source (MkpProject *project, gchar *target, AnjutaProjectGroup *parent, guint backtrack)
+		child = g_file_resolve_relative_path (directory, name);
+		exist = anjuta_directory_cache_query_exists (child);
+		g_object_unref (child);
+
+		return exist;
+	}
+	else
+	{
+		return anjuta_directory_cache_get_file_type (directory, name) != G_FILE_TYPE_UNKNOWN;
+	}
+}
+
+static const gchar *
+mkp_project_resolve_source (MkpProject *project, const gchar *target, AnjutaProjectGroup *parent, guint backtrack);
+
+/* Try all source suffixes of the pattern rules indexed with target suffix */
+static const gchar *
+mkp_project_resolve_suffix (MkpProject *project, const gchar *target, const gchar *suffix, AnjutaProjectGroup *parent, guint backtrack)
 {
-	GFile *child;
-	gboolean exist;
-	GHashTableIter iter;
-	gchar *key;
-	MkpRule *rule;
+	GList *item;
+	gsize length = suffix - target;
+	const gchar *resolved = NULL;
 
-	/* Check pattern rules */
-	if (backtrack < MAX_DEPENDENCIES)
+	for (item = g_hash_table_lookup (project->pattern_rules, suffix); (item != NULL) && (resolved == NULL); item = g_list_next (item))
+	{
+		gchar *source;
+
+		source = g_malloc (length + strlen ((const gchar *)item->data) + 1);
+		memcpy (source, target, length);
+		strcpy (source + length, (const gchar *)item->data);
+		
+		resolved = mkp_project_resolve_source (project, anjuta_string_pool_intern_take (project->strings, source), parent, backtrack);
+	}
+
+	return resolved;
+}
+
+/* Try the % pattern rules whose target suffix is at the end of the target and
+ * whose target prefix is at its beginning. The longest suffixes and prefixes
+ * are tried first, so the rules giving the shortest stem, then the rules
+ * in makefile order */
+static const gchar *
+mkp_project_resolve_stem (MkpProject *project, const gchar *target, AnjutaProjectGroup *parent, guint backtrack)
+{
+	const gchar *suffix;
+	gsize length = strlen (target);
+	const gchar *resolved = NULL;
+
+	for (suffix = target; (resolved == NULL) && (suffix <= target + length); suffix++)
 	{
-		for (g_hash_table_iter_init (&iter, project->rules); g_hash_table_iter_next (&iter, (gpointer)&key, (gpointer)&rule);)
+		MkpStemBucket *bucket;
+		guint i;
+
+		bucket = g_hash_table_lookup (project->stem_rules, suffix);
+		if (bucket == NULL) continue;
+
+		for (i = 0; (i < bucket->lengths->len) && (resolved == NULL); i++)
 		{
-			if (rule->pattern)
-			{
-				gchar *source;
-				
-				if (rule->part == NULL)
-				{	
-					/* simple suffix rule */
-					source = g_strconcat (target, rule->name, NULL);
-				}
-				else
-				{
-					/* double suffix rule */
-					if (strcmp (target + strlen (target) - strlen (rule->part), rule->part) == 0)
-					{
-						gchar *suffix;
+			gsize prefix_length = g_array_index (bucket->lengths, gsize, i);
+			gchar *prefix;
+			GList *item;
+			gsize stem;
 
-						source = g_strconcat (target, rule->name, NULL);
-						suffix = source + strlen (target) - strlen (rule->part);
+			/* The stem cannot be empty */
+			if (suffix - target <= prefix_length) continue;
+			stem = suffix - target - prefix_length;
 
-						memcpy (suffix, rule->name, rule->part - rule->name);
-						*(suffix + (rule->part - rule->name)) = '\0';
-					}
-					else
-					{
-						continue;
-					}
-				}
-					
-				source = mkp_project_find_source (project, source, parent, backtrack + 1);
+			prefix = g_strndup (target, prefix_length);
+			item = g_hash_table_lookup (bucket->prefixes, prefix);
+			g_free (prefix);
 
-				if (source != NULL)
-				{
-					g_free (target);
+			for (; (item != NULL) && (resolved == NULL); item = g_list_next (item))
+			{
+				MkpStemRule *rule = (MkpStemRule *)item->data;
 
-					return source;
-				}
+				resolved = mkp_project_resolve_source (project,
+					anjuta_string_pool_intern_take (project->strings, g_strdup_printf ("%s%.*s%s", rule->source_prefix, (int)stem, target + prefix_length, rule->source_suffix)),
+					parent, backtrack);
 			}
 		}
 	}
-		
-	child = g_file_get_child (anjuta_project_group_get_directory (parent), target);
-	exist = g_file_query_exists (child, NULL);
-	g_message ("target =%s= filename =%s=", target, g_file_get_parse_name (child));
-	g_object_unref (child);
 
-	if (!exist)
+	return resolved;
+}
+
+/* Find the source of an interned target name. The result is memoized only if
+ * it does not depend on the depth of the search, so if the dependency limit
+ * has not been reached and no circular rule has been found below the target
+ * or if the target is the first one searched. */
+static const gchar *
+mkp_project_resolve_source (MkpProject *project, const gchar *target, AnjutaProjectGroup *parent, guint backtrack)
+{
+	const gchar *resolved = NULL;
+	gpointer found;
+	gboolean partial;
+	
+	if (g_hash_table_lookup_extended (project->sources, target, NULL, &found))
 	{
-		g_free (target);
+		if (found != MKP_SOURCE_CHECKING) return (const gchar *)found;
+
+		/* Circular rule */
+		project->sources_partial = TRUE;
+
 		return NULL;
 	}
+
+	/* Mark the target while checking it, to stop on circular rules */
+	g_hash_table_insert (project->sources, (gpointer)target, MKP_SOURCE_CHECKING);
+	partial = project->sources_partial;
+	project->sources_partial = FALSE;
+	
+	/* Check pattern rules */
+	if (backtrack >= MAX_DEPENDENCIES)
+	{
+		project->sources_partial = TRUE;
+	}
+	else
+	{
+		const gchar *dot;
+
+		/* GNU make pattern rules have priority over suffix rules */
+		resolved = mkp_project_resolve_stem (project, target, parent, backtrack + 1);
+
+		/* Double suffix rules */
+		for (dot = strchr (target, '.'); (dot != NULL) && (resolved == NULL); dot = strchr (dot + 1, '.'))
+		{
+			resolved = mkp_project_resolve_suffix (project, target, dot, parent, backtrack + 1);
+		}
+
+		/* Single suffix rules are indexed with an empty suffix */
+		if (resolved == NULL)
+		{
+			resolved = mkp_project_resolve_suffix (project, target, target + strlen (target), parent, backtrack + 1);
+		}
+	}
+
+	if ((resolved == NULL) && mkp_project_source_exists (parent, target))
+	{
+		resolved = target;
+	}
+	if (project->sources_partial && (backtrack != 0))
+	{
+		g_hash_table_remove (project->sources, target);
+	}
 	else
 	{
-		return target;
+		g_hash_table_insert (project->sources, (gpointer)target, (gpointer)resolved);
 	}
+	project->sources_partial = (backtrack != 0) && (project->sources_partial || partial);
+
+	return resolved;
 }
 
+/* Find a source for target checking pattern rule. If no source is found,
+ * free target and return NULL, else free target and return a newly allocated
+ * source name */
+
+gchar *
+mkp_project_find_source (MkpProject *project, gchar *target, AnjutaProjectGroup *parent, guint backtrack)
+{
+	const gchar *source;
+	
+	source = mkp_project_resolve_source (project, anjuta_string_pool_intern_take (project->strings, target), parent, backtrack);
+
+	return g_strdup (source);
+}
+
+/* Check if the creation or the deletion of a file, given by its name relative
+ * to the project directory, can change the rules result. It is the case if
+ * the existence of the name has been checked when resolving a prerequisite or
+ * if it can be the source of a pattern rule. A file built from a source, like
+ * an object file, is not checked. */
+
+gboolean
+mkp_project_is_rule_file (MkpProject *project, const gchar *name)
+{
+	const gchar *interned;
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+	GList *item;
+	gsize length;
+
+	/* All prerequisites without an explicit rule and all tried candidates
+	 * are in the memoized sources */
+	interned = anjuta_string_pool_lookup (project->strings, name);
+	if ((interned != NULL) && g_hash_table_lookup_extended (project->sources, interned, NULL, &value))
+	{
+		if ((value == NULL) || (value == interned)) return TRUE;
+	}
+
+	/* Suffix rules sources */
+	length = strlen (name);
+	for (g_hash_table_iter_init (&iter, project->pattern_rules); g_hash_table_iter_next (&iter, &key, &value);)
+	{
+		for (item = (GList *)value; item != NULL; item = g_list_next (item))
+		{
+			gsize suffix = strlen ((const gchar *)item->data);
+
+			if ((length > suffix) && (strcmp (name + length - suffix, (const gchar *)item->data) == 0)) return TRUE;
+		}
+	}
+
+	/* % pattern rules sources, the stem cannot be empty */
+	for (item = project->stem_rule_list; item != NULL; item = g_list_next (item))
+	{
+		MkpStemRule *rule = (MkpStemRule *)item->data;
+		gsize prefix = strlen (rule->source_prefix);
+		gsize suffix = strlen (rule->source_suffix);
+
+		if ((length > prefix + suffix) &&
+			(strncmp (name, rule->source_prefix, prefix) == 0) &&
+			(strcmp (name + length - suffix, rule->source_suffix) == 0)) return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* Index pattern rules by target suffix, the value is the list of source
+ * suffixes */
+static void
+mkp_project_index_pattern_rules (MkpProject *project)
+{
+	GHashTableIter iter;
+	gpointer key;
+	MkpRule *rule;
+	GList *item;
+
+	g_hash_table_remove_all (project->pattern_rules);
+	g_hash_table_remove_all (project->stem_rules);
+	g_hash_table_remove_all (project->sources);
+	
+	for (g_hash_table_iter_init (&iter, project->rules); g_hash_table_iter_next (&iter, (gpointer)&key, (gpointer)&rule);)
+	{
+		const gchar *target;
+		const gchar *source;
+		GList *list;
+		
+		/* GNU make pattern rules are indexed below */
+		if (!rule->pattern || rule->stem) continue;
+
+		if (rule->part == NULL)
+		{
+			/* Single suffix rule */
+			target = "";
+			source = rule->name;
+		}
+		else
+		{
+			/* Double suffix rule */
+			target = rule->part;
+			source = anjuta_string_pool_intern_take (project->strings, g_strndup (rule->name, rule->part - rule->name));
+		}
+
+		list = g_hash_table_lookup (project->pattern_rules, target);
+		if (list == NULL)
+		{
+			g_hash_table_insert (project->pattern_rules, (gpointer)target, g_list_append (NULL, (gpointer)source));
+		}
+		else
+		{
+			/* The list head does not change */
+			g_list_append (list, (gpointer)source);
+		}
+	}
+
+	/* Stem rules are kept in reverse makefile order */
+	for (item = g_list_last (project->stem_rule_list); item != NULL; item = g_list_previous (item))
+	{
+		MkpStemRule *stem = (MkpStemRule *)item->data;
+		MkpStemBucket *bucket;
+
+		bucket = g_hash_table_lookup (project->stem_rules, stem->suffix);
+		if (bucket == NULL)
+		{
+			bucket = mkp_stem_bucket_new ();
+			g_hash_table_insert (project->stem_rules, (gpointer)stem->suffix, bucket);
+		}
+		mkp_stem_bucket_add (bucket, stem);
+	}
+}
 
 /* Parser functions
  *---------------------------------------------------------------------------*/
@@ -163,7 +488,7 @@ mkp_project_add_rule (MkpProject *project, AnjutaToken *group)
 	for (arg = anjuta_token_first_word (targ); arg != NULL; arg = anjuta_token_next_word (arg))
 	{
 		AnjutaToken *src;
-		gchar *target;
+		const gchar *target;
 		gboolean order = FALSE;
 		gboolean no_token = TRUE;
 		MkpRule *rule;
@@ -175,18 +500,18 @@ mkp_project_add_rule (MkpProject *project, AnjutaToken *group)
 			{
 				if (anjuta_token_get_type (src) != MK_TOKEN_ORDER)
 				{
-					target = anjuta_token_evaluate (src);
+					target = anjuta_string_pool_intern_take (project->strings, anjuta_token_evaluate (src));
+					if (target == NULL) continue;
 					
 					rule = g_hash_table_lookup (project->rules, target);
 					if (rule == NULL)
 					{
 						rule = mkp_rule_new (target, NULL);
-						g_hash_table_insert (project->rules, rule->name, rule);
+						g_hash_table_insert (project->rules, (gpointer)rule->name, rule);
 					}
 					rule->phony = TRUE;
 					
 					g_message ("    with target %s", target);
-					if (target != NULL) g_free (target);
 				}
 			}
 			break;
@@ -195,12 +520,13 @@ mkp_project_add_rule (MkpProject *project, AnjutaToken *group)
 			{
 				if (anjuta_token_get_type (src) != MK_TOKEN_ORDER)
 				{
-					gchar *suffix;
+					const gchar *suffix;
 
-					suffix = anjuta_token_evaluate (src);
+					suffix = anjuta_string_pool_intern_take (project->strings, anjuta_token_evaluate (src));
+					if (suffix == NULL) continue;
 					/* The pointer value must only be not NULL, it does not matter if it is
 	 				 * invalid */
-					g_hash_table_replace (project->suffix, suffix, suffix);
+					g_hash_table_replace (project->suffix, (gpointer)suffix, (gpointer)suffix);
 					g_message ("    with suffix %s", suffix);
 					no_token = FALSE;
 				}
@@ -225,7 +551,9 @@ mkp_project_add_rule (MkpProject *project, AnjutaToken *group)
 			/* Do nothing with these targets, just ignore them */
 			break;
 		default:
-			target = g_strstrip (anjuta_token_evaluate (arg));
+			target = anjuta_token_evaluate (arg);
+			if (target == NULL) break;
+			target = anjuta_string_pool_intern_take (project->strings, g_strstrip ((gchar *)target));
 			if (*target == '\0') break;	
 			g_message ("add rule =%s=", target);
 				
@@ -233,16 +561,33 @@ mkp_project_add_rule (MkpProject *project, AnjutaToken *group)
 			if (rule == NULL)
 			{
 				rule = mkp_rule_new (target, group);
-				g_hash_table_insert (project->rules, rule->name, rule);
+				g_hash_table_insert (project->rules, (gpointer)rule->name, rule);
 			}
 			else
 			{
 				rule->rule = group;
 			}
+
+			if (strchr (target, '%') != NULL)
+			{
+				/* Each pattern rule statement is a different rule, its
+				 * source is its first prerequisite which needs a % too */
+				src = anjuta_token_first_word (dep);
+				if ((src != NULL) && (anjuta_token_get_type (src) != MK_TOKEN_ORDER))
+				{
+					gchar *source = anjuta_token_evaluate (src);
+
+					if ((source != NULL) && (strchr (g_strstrip (source), '%') != NULL))
+					{
+						project->stem_rule_list = g_list_prepend (project->stem_rule_list, mkp_stem_rule_new (project, target, source));
+					}
+					g_free (source);
+				}
+			}
 				
 			for (src = anjuta_token_first_word (dep); src != NULL; src = anjuta_token_next_word (src))
 			{
-				gchar *src_name = anjuta_token_evaluate (src);
+				const gchar *src_name = anjuta_string_pool_intern_take (project->strings, anjuta_token_evaluate (src));
 
 				if (src_name != NULL)
 				{
@@ -251,11 +596,81 @@ mkp_project_add_rule (MkpProject *project, AnjutaToken *group)
 					{
 						order = TRUE;
 					}
-					rule->prerequisite = g_list_prepend (rule->prerequisite, src_name);
+					rule->prerequisite = g_list_prepend (rule->prerequisite, (gpointer)src_name);
 				}
 			}
+		}
+	}
+}
+
+/* Check if name is made of two suffixes, return the beginning of the second
+ * one or NULL. Only the splits where the end of the name is a suffix need a
+ * second lookup for the beginning. */
+static const gchar *
+mkp_project_find_double_suffix (MkpProject *project, const gchar *name)
+{
+	const gchar *part;
+	gchar *first = NULL;
+
+	if (*name == '\0') return NULL;
+	
+	for (part = name + 1; *part != '\0'; part++)
+	{
+		if (g_hash_table_lookup (project->suffix, part) != NULL)
+		{
+			if (first == NULL) first = g_strdup (name);
+			first[part - name] = '\0';
+			if (g_hash_table_lookup (project->suffix, first) != NULL) break;
+			first[part - name] = name[part - name];
+		}
+	}
+	g_free (first);
+
+	return *part == '\0' ? NULL : part;
+}
+
+/* Build the dependency graph of all rules. A file without explicit rule
+ * depends on the source found using the pattern and suffix rules. */
+static void
+mkp_project_build_graph (MkpProject *project, AnjutaProjectGroup *parent)
+{
+	GHashTableIter iter;
+	gpointer key;
+	MkpRule *rule;
+	guint explicit;
+	guint node;
+
+	mkp_graph_free (project->graph);
+	project->graph = mkp_graph_new ();
+	
+	for (g_hash_table_iter_init (&iter, project->rules); g_hash_table_iter_next (&iter, (gpointer)&key, (gpointer)&rule);)
+	{
+		GList *prerequisite;
+		
+		if (rule->pattern) continue;
+
+		node = mkp_graph_add_node (project->graph, rule->name);
+		/* Prerequisites are stored in reverse order */
+		for (prerequisite = g_list_last (rule->prerequisite); prerequisite != NULL; prerequisite = g_list_previous (prerequisite))
+		{
+			mkp_graph_add_edge (project->graph, node, mkp_graph_add_node (project->graph, (const gchar *)prerequisite->data));
+		}
+	}
+
+	/* Sources found for new nodes are existing files, they need no rule */
+	explicit = mkp_graph_get_node_count (project->graph);
+	for (node = 0; node < explicit; node++)
+	{
+		const gchar *name = mkp_graph_get_node_name (project->graph, node);
+		const gchar *source;
+
+		rule = g_hash_table_lookup (project->rules, name);
+		if ((rule != NULL) && !rule->pattern) continue;
 
-			if (target != NULL) g_free (target);
+		source = mkp_project_resolve_source (project, name, parent, 0);
+		if ((source != NULL) && (source != name))
+		{
+			mkp_graph_add_edge (project->graph, node, mkp_graph_add_node (project->graph, source));
 		}
 	}
 }
@@ -263,6 +678,12 @@ mkp_project_add_rule (MkpProject *project, AnjutaToken *group)
 /* Public functions
  *---------------------------------------------------------------------------*/
 
+MkpGraph *
+mkp_project_get_graph (MkpProject *project)
+{
+	return project->graph;
+}
+
 void
 mkp_project_enumerate_targets (MkpProject *project, AnjutaProjectGroup *parent)
 {
@@ -275,7 +696,13 @@ mkp_project_enumerate_targets (MkpProject *project, AnjutaProjectGroup *parent)
 	{
 		if (rule->phony) continue;
 
-		if (g_hash_table_lookup (project->suffix, rule->name))
+		if (strchr (rule->name, '%') != NULL)
+		{
+			/* GNU make pattern rule */
+			rule->pattern = TRUE;
+			rule->stem = TRUE;
+		}
+		else if (g_hash_table_lookup (project->suffix, rule->name))
 		{
 			/* Single suffix rule */
 			rule->pattern = TRUE;
@@ -283,37 +710,14 @@ mkp_project_enumerate_targets (MkpProject *project, AnjutaProjectGroup *parent)
 		}
 		else
 		{
-			GString *pattern = g_string_sized_new (16);
-			GList *suffix;
-			GList *src;
-			
-			/* Check double suffix rule */
-			suffix = g_hash_table_get_keys (project->suffix);
-			
-			for (src = g_list_first (suffix); src != NULL; src = g_list_next (src))
-			{
-				GList *obj;
-
-				for (obj = g_list_first (suffix); obj != NULL; obj = g_list_next (obj))
-				{
-					g_string_assign (pattern, src->data);
-					g_string_append (pattern, obj->data);
-
-					if (strcmp (pattern->str, rule->name) == 0)
-					{
-						rule->pattern = TRUE;
-						rule->part = rule->name + strlen (src->data);
-						break;
-					}
-				}
-				if (rule->pattern) break;
-			}
-
-			g_string_free (pattern, TRUE);
-			g_list_free (suffix);
+			rule->part = mkp_project_find_double_suffix (project, rule->name);
+			rule->pattern = rule->part != NULL;
 		}
 	}
 
+	mkp_project_index_pattern_rules (project);
+	mkp_project_build_graph (project, parent);
+
 	/* Create new target */
 	for (g_hash_table_iter_init (&iter, project->rules); g_hash_table_iter_next (&iter, (gpointer)&key, (gpointer)&rule);)
 	{
@@ -338,7 +742,6 @@ mkp_project_enumerate_targets (MkpProject *project, AnjutaProjectGroup *parent)
 		for (arg = anjuta_token_first_word (prerequisite); arg != NULL; arg = anjuta_token_next_word (arg))
 		{
 			MkpSource *source;
-			GFile *src_file;
 			gchar *name;
 
 			name = anjuta_token_evaluate (arg);
@@ -350,9 +753,7 @@ mkp_project_enumerate_targets (MkpProject *project, AnjutaProjectGroup *parent)
 
 			if (name != NULL)
 			{
-				src_file = g_file_get_child (project->root_file, name);
-				source = mkp_source_new (src_file);
-				g_object_unref (src_file);
+				source = mkp_source_new (anjuta_string_pool_intern (project->strings, name));
 				anjuta_project_node_append (target, source);
 
 				g_free (name);
@@ -366,7 +767,13 @@ void
 mkp_project_init_rules (MkpProject *project)
 {
 	project->rules = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify)mkp_rule_free);
-	project->suffix = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	project->suffix = g_hash_table_new (g_str_hash, g_str_equal);
+	project->pattern_rules = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify)g_list_free);
+	project->stem_rules = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify)mkp_stem_bucket_free);
+	project->stem_rule_list = NULL;
+	project->sources = g_hash_table_new (g_str_hash, g_str_equal);
+	project->sources_partial = FALSE;
+	project->graph = NULL;
 }
 
 void 
@@ -376,5 +783,15 @@ mkp_project_free_rules (MkpProject *project)
 	project->rules = NULL;
 	if (project->suffix) g_hash_table_destroy (project->suffix);
 	project->suffix = NULL;
+	if (project->pattern_rules) g_hash_table_destroy (project->pattern_rules);
+	project->pattern_rules = NULL;
+	if (project->stem_rules) g_hash_table_destroy (project->stem_rules);
+	project->stem_rules = NULL;
+	mkp_stem_rule_list_free (project->stem_rule_list);
+	project->stem_rule_list = NULL;
+	if (project->sources) g_hash_table_destroy (project->sources);
+	project->sources = NULL;
+	mkp_graph_free (project->graph);
+	project->graph = NULL;
 }
 
@@ -33,6 +33,7 @@ void mkp_project_init_rules (MkpProject *project);
 void mkp_project_free_rules (MkpProject *project);
 void mkp_project_enumerate_targets (MkpProject *project, MkpGroup *parent);
 void mkp_project_add_rule (MkpProject *project, AnjutaToken *group);
+gboolean mkp_project_is_rule_file (MkpProject *project, const gchar *name);
 
 
 G_END_DECLS
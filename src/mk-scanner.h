@@ -38,6 +38,14 @@ G_BEGIN_DECLS
 
 typedef struct _MkpScanner MkpScanner;
 
+/* Token of a variable value, kept to replay it without scanning again */
+typedef struct
+{
+	gint type;
+	const gchar *string;
+	gsize length;
+} MkpScannerToken;
+
 MkpScanner *mkp_scanner_new (MkpProject *project);
 void mkp_scanner_free (MkpScanner *scanner);
 
@@ -47,6 +55,10 @@ void mkp_scanner_update_variable (MkpScanner *scanner, AnjutaToken *variable);
 void mkp_scanner_parse_variable (MkpScanner *scanner, AnjutaToken *variable);
 void mkp_scanner_add_rule (MkpScanner *scanner, AnjutaToken *rule);
 
+GArray *mkp_scanner_tokenize (MkpProject *project, AnjutaToken *value);
+GArray *mkp_scanner_expand_tokens (MkpProject *project, GArray *tokens);
+gchar *mkp_scanner_evaluate_tokens (MkpProject *project, GArray *tokens);
+
 void mkp_yyerror (YYLTYPE *loc, MkpScanner *scanner, char const *s);
 
 typedef enum